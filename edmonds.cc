@@ -1,7 +1,52 @@
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <list>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "edmonds.h"
 
 using namespace std;
 
@@ -9,13 +54,472 @@ struct Edge {
     int from, to, weight;
 };
 
+/**
+ * @brief A single completed span recorded by the Chrome tracer.
+ *
+ * Names and argument keys must be string literals (or otherwise outlive the trace),
+ * since only the pointers are stored.
+ */
+struct TraceEvent {
+    static const int MAX_ARGS = 4;
+    const char* name;
+    long long startNs, durationNs;
+    int argCount;
+    const char* argNames[MAX_ARGS];
+    long long argValues[MAX_ARGS];
+};
+
+/**
+ * @brief Per-thread event buffer. Only the owning thread appends to it, so recording
+ * a span never takes a lock; the registry mutex is touched once per thread, on its
+ * first recorded span.
+ */
+struct TraceBuffer {
+    int tid;
+    vector<TraceEvent> events;
+};
+
+atomic<bool> traceEnabled{false};
+mutex traceRegistryMutex;
+vector<shared_ptr<TraceBuffer>> traceRegistry;
+const chrono::steady_clock::time_point traceEpoch = chrono::steady_clock::now();
+
+TraceBuffer& threadTraceBuffer() {
+    thread_local shared_ptr<TraceBuffer> buffer;
+    if (!buffer) {
+        buffer = make_shared<TraceBuffer>();
+        lock_guard<mutex> lock(traceRegistryMutex);
+        buffer->tid = (int)traceRegistry.size() + 1;
+        traceRegistry.push_back(buffer);
+    }
+    return *buffer;
+}
+
+long long traceNowNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - traceEpoch).count();
+}
+
+/**
+ * @brief Turns Chrome trace-event recording on or off. Tracing is off by default, and a
+ * disabled span costs a single relaxed atomic load.
+ */
+void enableChromeTrace(bool enabled) {
+    traceEnabled.store(enabled, memory_order_relaxed);
+}
+
+/**
+ * @brief RAII span: records a complete ("X") event covering its lifetime on the calling thread.
+ *
+ * Spans opened inside other spans on the same thread nest in the trace viewer.
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name) : active(traceEnabled.load(memory_order_relaxed)) {
+        if (active) {
+            event.name = name;
+            event.argCount = 0;
+            event.startNs = traceNowNs();
+        }
+    }
+
+    void arg(const char* key, long long value) {
+        if (active && event.argCount < TraceEvent::MAX_ARGS) {
+            event.argNames[event.argCount] = key;
+            event.argValues[event.argCount] = value;
+            event.argCount++;
+        }
+    }
+
+    /**
+     * @brief Closes the span before the end of its scope; later calls and the destructor are no-ops.
+     */
+    void end() {
+        if (active) {
+            active = false;
+            event.durationNs = traceNowNs() - event.startNs;
+            threadTraceBuffer().events.push_back(event);
+        }
+    }
+
+    ~TraceSpan() {
+        end();
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    bool active;
+    TraceEvent event;
+};
+
+/**
+ * @brief Writes every recorded span as Chrome trace-event JSON, loadable in Perfetto or chrome://tracing.
+ *
+ * @param out The stream to write the JSON object to.
+ *
+ * @note Call only once the traced threads are quiescent (e.g. after a batch has been joined);
+ * the per-thread buffers are read without synchronising with their writers.
+ */
+void writeChromeTrace(ostream& out) {
+    lock_guard<mutex> lock(traceRegistryMutex);
+    ostringstream json;
+    json.setf(ios::fixed);
+    json.precision(3);
+    json << "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto& buffer : traceRegistry) {
+        for (const TraceEvent& event : buffer->events) {
+            json << (first ? "\n" : ",\n");
+            first = false;
+            json << "{\"name\":\"" << event.name << "\",\"cat\":\"edmonds\",\"ph\":\"X\""
+                 << ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0
+                 << ",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{";
+            for (int i = 0; i < event.argCount; i++) {
+                json << (i ? "," : "") << "\"" << event.argNames[i] << "\":" << event.argValues[i];
+            }
+            json << "}}";
+        }
+    }
+    json << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    out << json.str();
+}
+
+/**
+ * @brief Discards all recorded spans. Like writeChromeTrace, only safe while traced threads are quiescent.
+ */
+void clearChromeTrace() {
+    lock_guard<mutex> lock(traceRegistryMutex);
+    for (const auto& buffer : traceRegistry) {
+        buffer->events.clear();
+    }
+}
+
+/**
+ * @brief A memory_resource that forwards to an upstream resource and counts what passes through it.
+ *
+ * Reports the number of allocations, the total bytes requested and the peak number of bytes
+ * live at once, so the footprint of a single solve can be measured by passing one of these
+ * to chuLiuEdmonds and calling reset() between solves.
+ *
+ * @note Not thread-safe; use one instance per solving thread.
+ */
+class CountingMemoryResource : public pmr::memory_resource {
+public:
+    explicit CountingMemoryResource(pmr::memory_resource* upstream = pmr::get_default_resource())
+        : upstream(upstream) {}
+
+    size_t allocations() const { return allocationCount; }
+    size_t bytesAllocated() const { return totalBytes; }
+    size_t currentBytes() const { return liveBytes; }
+    size_t peakBytes() const { return highWaterBytes; }
+
+    /**
+     * @brief Clears the counters; the peak restarts from the bytes currently live.
+     */
+    void reset() {
+        allocationCount = 0;
+        totalBytes = 0;
+        highWaterBytes = liveBytes;
+    }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* p = upstream->allocate(bytes, alignment);
+        allocationCount++;
+        totalBytes += bytes;
+        liveBytes += bytes;
+        highWaterBytes = max(highWaterBytes, liveBytes);
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        upstream->deallocate(p, bytes, alignment);
+        liveBytes -= bytes;
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    pmr::memory_resource* upstream;
+    size_t allocationCount = 0;
+    size_t totalBytes = 0;
+    size_t liveBytes = 0;
+    size_t highWaterBytes = 0;
+};
+
+/**
+ * @brief Outcome of a chuLiuEdmonds solve that reports errors explicitly instead of returning -1.
+ */
+enum class EdmondsStatus {
+    Ok,
+    NoArborescence,     // some node is not reachable from the root
+    WorkspaceTooSmall,  // a workspace span is shorter than requiredWorkspace asks for
+    InvalidArgument,    // bad node count, root or edge endpoint
+    IoError,            // an input or scratch file could not be read or written
+    Cancelled,          // the solve's CancellationToken was cancelled
+    TimedOut,           // the solve's deadline passed
+    OutOfMemory         // scratch memory for the solve could not be allocated
+};
+
+/**
+ * @brief A cancellation flag shared by a solve and everyone who may want to stop it; copies
+ * share the flag.
+ */
+class CancellationToken {
+public:
+    CancellationToken() : flag(make_shared<atomic<bool>>(false)) {}
+
+    void cancel() const { flag->store(true, memory_order_relaxed); }
+    bool cancelled() const { return flag->load(memory_order_relaxed); }
+
+private:
+    shared_ptr<atomic<bool>> flag;
+};
+
+/**
+ * @brief When a solve should give up: on cancellation of token, or once deadline has passed.
+ *
+ * Solvers poll it between rounds and every STOP_CHECK_EDGES edges of a long scan, so a stop
+ * takes effect within one such slice of work.
+ */
+struct SolveStop {
+    static const size_t STOP_CHECK_EDGES = 1 << 16;
+
+    CancellationToken token;
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+
+    /**
+     * @return EdmondsStatus::Cancelled or TimedOut if the solve should stop, nullopt otherwise.
+     */
+    optional<EdmondsStatus> check() const {
+        if (token.cancelled()) return EdmondsStatus::Cancelled;
+        if (deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= deadline) {
+            return EdmondsStatus::TimedOut;
+        }
+        return nullopt;
+    }
+};
+
+/**
+ * @brief SolveStop::check for an optional stop condition.
+ */
+optional<EdmondsStatus> checkStop(const SolveStop* stop) {
+    return stop ? stop->check() : nullopt;
+}
+
+/**
+ * @brief Element counts of the buffers a chuLiuEdmonds solve needs, as returned by requiredWorkspace.
+ */
+struct EdmondsWorkspaceSize {
+    size_t nodeInts;      // length of each of the NODE_ARRAYS per-node buffers
+    size_t scratchEdges;  // length of edgeScratch
+};
+
+/**
+ * @brief Caller-owned buffers for an allocation-free chuLiuEdmonds solve.
+ *
+ * inFrom, inWeight, cycle, visited and id hold per-node state; edgeScratch is split into two halves
+ * that alternately store the contracted graphs. Their contents on entry are irrelevant.
+ */
+struct EdmondsWorkspace {
+    static const int NODE_ARRAYS = 5;
+    span<int> inFrom, inWeight, cycle, visited, id;
+    span<Edge> edgeScratch;
+};
+
+/**
+ * @brief Returns the exact buffer sizes chuLiuEdmonds needs for a graph with n nodes and numEdges edges.
+ *
+ * A contracted graph never has more edges than the input, so two edge lists of the input's
+ * size are enough for any number of rounds.
+ */
+EdmondsWorkspaceSize requiredWorkspace(int n, size_t numEdges) {
+    return {(size_t)max(n, 0), 2 * numEdges};
+}
+
+/**
+ * @brief Read-only view over edges stored as three parallel arrays (structure of arrays), so
+ * callers that keep from/to/weight columns can be solved without packing them into Edge structs.
+ */
+struct EdgeArraysView {
+    const int32_t* from;
+    const int32_t* to;
+    const int32_t* weight;
+    size_t count;
+
+    size_t size() const { return count; }
+    Edge operator[](size_t i) const { return {from[i], to[i], weight[i]}; }
+};
+
+/**
+ * @brief Edges forced into or kept out of a solve, as bitsets over edge indices, so that many
+ * constrained variants can be solved against one shared graph without copying it.
+ *
+ * Forcing an edge (u, v) also marks v, which keeps every other edge into v out of the solve; the
+ * solvers then only ask allowed() while choosing minimum in-edges and building contracted graphs.
+ * Constraints that contradict each other, such as two forced edges into one node, a forced edge
+ * that is also forbidden or into the root, or a forced cycle, leave no arborescence.
+ */
+class EdgeConstraints {
+public:
+    EdgeConstraints(int n, size_t numEdges)
+        : forcedEdges(words(numEdges)), forbiddenEdges(words(numEdges)), forcedTargets(words(max(n, 0))),
+          numNodes(n), numEdges(numEdges) {}
+
+    /**
+     * @brief Forces edges[e] into the arborescence.
+     */
+    template <class EdgeView>
+    void force(const EdgeView& edges, size_t e) {
+        int to = edges[e].to;
+        if (test(forcedTargets, to) && !test(forcedEdges, e)) conflicting = true;
+        set(forcedEdges, e);
+        set(forcedTargets, to);
+    }
+
+    /**
+     * @brief Keeps edge e out of the arborescence.
+     */
+    void forbid(size_t e) { set(forbiddenEdges, e); }
+
+    /**
+     * @brief Drops every constraint, keeping the sizes.
+     */
+    void clear() {
+        fill(forcedEdges.begin(), forcedEdges.end(), 0);
+        fill(forbiddenEdges.begin(), forbiddenEdges.end(), 0);
+        fill(forcedTargets.begin(), forcedTargets.end(), 0);
+        conflicting = false;
+    }
+
+    bool forced(size_t e) const { return test(forcedEdges, e); }
+    bool forbidden(size_t e) const { return test(forbiddenEdges, e); }
+    bool hasForcedEdge(int node) const { return test(forcedTargets, node); }
+
+    /**
+     * @brief Whether edge e, which enters node to, may be chosen.
+     */
+    bool allowed(size_t e, int to) const {
+        return !test(forbiddenEdges, e) && (!test(forcedTargets, to) || test(forcedEdges, e));
+    }
+
+    /**
+     * @brief Whether some arborescence rooted at root could meet the constraints as far as they
+     *        go on their own: no forced edge is forbidden or enters the root, and no node has two.
+     */
+    bool consistent(int root) const {
+        if (conflicting || test(forcedTargets, root)) return false;
+        for (size_t w = 0; w < forcedEdges.size(); w++) {
+            if (forcedEdges[w] & forbiddenEdges[w]) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Whether the constraints were sized for a graph of n nodes and numEdges edges.
+     */
+    bool fits(int n, size_t edgeCount) const { return numNodes == n && numEdges == edgeCount; }
+
+private:
+    static size_t words(size_t bits) { return (bits + 63) / 64; }
+    static void set(vector<uint64_t>& bits, size_t i) { bits[i / 64] |= uint64_t(1) << (i % 64); }
+    static bool test(const vector<uint64_t>& bits, size_t i) { return bits[i / 64] >> (i % 64) & 1; }
+
+    vector<uint64_t> forcedEdges, forbiddenEdges, forcedTargets;
+    int numNodes;
+    size_t numEdges;
+    bool conflicting = false;   // two edges were forced into one node
+};
+
+/**
+ * @brief Finds the cycles formed by the chosen incoming edges.
+ *
+ * @param inFrom For each non-root node, the source of its chosen incoming edge.
+ * @param cycle Receives for each node the id of the cycle it belongs to, or -1.
+ * @param visited Scratch space of n ints.
+ * @return The number of cycles found.
+ */
+int detectCycles(int n, int root, span<const int> inFrom, span<int> cycle, span<int> visited) {
+    int cycleCount = 0;
+    fill(cycle.begin(), cycle.begin() + n, -1);
+    fill(visited.begin(), visited.begin() + n, 0);
+    visited[root] = 2;
+    for (int i = 0; i < n; i++) {
+        if(visited[i] == 0){
+            int u = i;
+            bool hasCycle = false;
+            while(visited[u] != 2 && !hasCycle){
+                if(visited[u] == 1) {
+                    hasCycle = true;
+                    break;
+                }
+                visited[u] = 1;
+                u = inFrom[u];
+            }
+            if(hasCycle){
+                cycleCount++;
+                int cycleId = cycleCount - 1;
+                int v = u;
+                do {
+                    cycle[v] = cycleId;
+                    v = inFrom[v];
+                } while (v != u);
+            }
+            int u2 = i;
+            while(visited[u2] != 2) {
+                visited[u2] = 2;
+                u2 = inFrom[u2];
+            }
+        }
+    }
+    return cycleCount;
+}
+
+/**
+ * @brief Numbers the nodes of the contracted graph: every cycle becomes a single node and every
+ * other node keeps a node of its own.
+ *
+ * @param id Receives for each node its 1-based node in the contracted graph.
+ * @return The number of nodes in the contracted graph.
+ */
+int numberContractedNodes(int n, span<const int> inFrom, span<const int> cycle, span<int> id) {
+    fill(id.begin(), id.begin() + n, 0);
+    int numNodes = 0;
+    for (int i = 0; i < n; ++i) {
+        if (cycle[i] != -1) {
+            if (id[i] == 0) {
+                id[i] = ++numNodes;
+                int node = inFrom[i];
+                while (node != i) {
+                    id[node] = numNodes;
+                    node = inFrom[node];
+                }
+            }
+        }else {
+            id[i] = ++numNodes;
+        }
+    }
+    return numNodes;
+}
+
 /**
  * @brief Implements the Chu-Liu-Edmonds algorithm to find the minimum spanning arborescence (MSA) of a directed graph.
  * 
  * @param n The number of nodes in the graph.
  * @param root The root node of the arborescence.
- * @param edges A vector of Edge structs representing the directed edges of the graph.
- * @return The total weight of the minimum spanning arborescence, or -1 if no arborescence exists.
+ * @param edges The directed edges of the graph: any view with size() and an operator[] yielding an Edge,
+ *              such as span<const Edge> or EdgeArraysView. They are read front to back in each pass;
+ *              contracted graphs are built in the workspace.
+ * @param workspace Caller-provided buffers, sized as requiredWorkspace(n, edges.size()) says.
+ * @param minWeight Receives the total weight of the minimum spanning arborescence on success.
+ * @param stop If non-null, checked before each round and every SolveStop::STOP_CHECK_EDGES edges.
+ * @param constraints If non-null, the edges it forbids are skipped in the first round, both when
+ *                    choosing minimum in-edges and when building the contracted graph, so later
+ *                    rounds never see them. It must be sized for n and edges.size().
+ * @return EdmondsStatus::Ok, or the reason no weight was produced. With tracing disabled the solve
+ *         never touches the heap.
  * 
  * The algorithm works by iteratively finding the minimum incoming edge for each node,
  * detecting cycles, contracting cycles into single nodes, and recalculating edge weights.
@@ -25,272 +529,6604 @@ struct Edge {
  * @note Time Complexity: O(VE), where V is the number of vertices and E is the number of edges.
  * @note Space Complexity: O(V + E), where V is the number of vertices and E is the number of edges.
  */
-int chuLiuEdmonds(int n, int root, vector<Edge>& edges) {
-    // minWeight stores the total weight of the minimum spanning tree
-    // inEdge stores for each node, the index of the incoming edge with the minimum weight
+template <class EdgeView>
+EdmondsStatus chuLiuEdmondsOver(int n, int root, const EdgeView& edges, EdmondsWorkspace workspace, int& minWeight,
+                                const SolveStop* stop = nullptr, const EdgeConstraints* constraints = nullptr) {
+    // minWeight accumulates the total weight of the minimum spanning tree
+    // inFrom and inWeight store for each node the source and weight of its minimum incoming edge
+    // (inFrom is -1 while a node has none); keeping both means no pass needs random access to the edges
     // cycle stores for each node, the id of the cycle it belongs to, or -1 if it doesn't belong to any cycle
     // visited is a helper array used in cycle detection
-    // contractedEdges stores the edges after a cycle is contracted into a single node
-    int minWeight = 0;
-    vector<int> inEdge(n, -1), cycle(n, -1), visited(n, 0);
-    vector<Edge> contractedEdges;
+    // id maps each node to its node in the contracted graph (1-based, 0 while unassigned)
+    // the two halves of edgeScratch alternate as the storage for the contracted graphs
+    TraceSpan solveSpan("chuLiuEdmonds");
+    solveSpan.arg("n", n);
+    solveSpan.arg("E", (long long)edges.size());
+    if (n <= 0 || root < 0 || root >= n) return EdmondsStatus::InvalidArgument;
+    EdmondsWorkspaceSize size = requiredWorkspace(n, edges.size());
+    if (workspace.inFrom.size() < size.nodeInts || workspace.inWeight.size() < size.nodeInts ||
+        workspace.cycle.size() < size.nodeInts || workspace.visited.size() < size.nodeInts ||
+        workspace.id.size() < size.nodeInts || workspace.edgeScratch.size() < size.scratchEdges) {
+        return EdmondsStatus::WorkspaceTooSmall;
+    }
+    for (size_t e = 0; e < edges.size(); e++) {
+        Edge edge = edges[e];
+        if (edge.from < 0 || edge.from >= n || edge.to < 0 || edge.to >= n) return EdmondsStatus::InvalidArgument;
+    }
+    if (constraints && !constraints->fits(n, edges.size())) return EdmondsStatus::InvalidArgument;
+    if (constraints && !constraints->consistent(root)) return EdmondsStatus::NoArborescence;
+
+    span<int> inFrom = workspace.inFrom, inWeight = workspace.inWeight, id = workspace.id;
+    Edge* contractedEdges[2] = {workspace.edgeScratch.data(), workspace.edgeScratch.data() + edges.size()};
+    size_t numContracted = 0;
+    int totalCycles = 0;
+    minWeight = 0;
 
-    while (true) {
+    // Runs one round over the edge list `current`: the caller's edges in round 0, the previous
+    // round's contracted graph afterwards. Returns the final status, or nullopt once the round
+    // has contracted its cycles into contractedEdges[round % 2].
+    auto runRound = [&](const auto& current, int round) -> optional<EdmondsStatus> {
+        size_t numEdges = current.size();
+        // the caller's edge indices only mean something in round 0
+        const EdgeConstraints* masked = round == 0 ? constraints : nullptr;
+        TraceSpan roundSpan("round");
+        roundSpan.arg("round", round);
+        roundSpan.arg("n", n);
+        roundSpan.arg("E", (long long)numEdges);
+        TraceSpan selectSpan("selectMinInEdges");
         for (int i = 0; i < n; i++) {
-            inEdge[i] = -1;
+            inFrom[i] = -1;
         }
 
-        for (Edge& edge : edges) {
-            if (edge.from == edge.to) continue;
-            if (inEdge[edge.to] == -1 || edge.weight < edges[inEdge[edge.to]].weight) {
-                inEdge[edge.to] = &edge - &edges[0];
+        for (size_t slice = 0; slice < numEdges; slice += SolveStop::STOP_CHECK_EDGES) {
+            if (optional<EdmondsStatus> stopped = checkStop(stop)) return stopped;
+            size_t sliceEnd = min(numEdges, slice + SolveStop::STOP_CHECK_EDGES);
+            for (size_t e = slice; e < sliceEnd; e++) {
+                Edge edge = current[e];
+                if (masked && !masked->allowed(e, edge.to)) continue;
+                if (edge.from == edge.to) continue;
+                if (inFrom[edge.to] == -1 || edge.weight < inWeight[edge.to]) {
+                    inFrom[edge.to] = edge.from;
+                    inWeight[edge.to] = edge.weight;
+                }
             }
         }
 
         for(int i = 0; i < n; i++){
-            if(i != root && inEdge[i] == -1) return -1;
-        }
-
-        int cycleCount = 0;
-        fill(cycle.begin(), cycle.end(), -1);
-        fill(visited.begin(), visited.end(), 0);
-        visited[root] = 2;
-        for (int i = 0; i < n; i++) {
-            if(visited[i] == 0){
-                int u = i;
-                bool hasCycle = false;
-                while(visited[u] != 2 && !hasCycle){
-                    if(visited[u] == 1) {
-                        hasCycle = true;
-                        break;
-                    }
-                    visited[u] = 1;
-                    u = edges[inEdge[u]].from;
-                }
-                if(hasCycle){
-                    cycleCount++;
-                    int cycleId = cycleCount - 1;
-                    int v = u;
-                    do {
-                        cycle[v] = cycleId;
-                        v = edges[inEdge[v]].from;
-                    } while (v != u);
-                }
-                int u2 = i;
-                while(visited[u2] != 2) {
-                    visited[u2] = 2;
-                    u2 = edges[inEdge[u2]].from;
-                }
+            if(i != root && inFrom[i] == -1) {
+                return EdmondsStatus::NoArborescence;
             }
         }
+        selectSpan.end();
 
+        TraceSpan detectSpan("detectCycles");
+        int cycleCount = detectCycles(n, root, inFrom, workspace.cycle, workspace.visited);
         for (int i = 0; i < n; i++) {
-            if (i != root && inEdge[i] != -1) {
-                minWeight += edges[inEdge[i]].weight;
+            if (i != root) {
+                minWeight += inWeight[i];
             }
         }
+        totalCycles += cycleCount;
+        roundSpan.arg("cycles", cycleCount);
+        detectSpan.end();
         
         if (cycleCount == 0) {
-            return minWeight;
-        }
-
-        contractedEdges.clear();
-        vector<int> id(n, 0);
-        int numNodes = 0;
-        for (int i = 0; i < n; ++i) {
-            if (cycle[i] != -1) {
-                if (id[i] == 0) {
-                    id[i] = ++numNodes;
-                    int current = edges[inEdge[i]].from;
-                    while (current != i) {
-                        id[current] = numNodes;
-                        current = edges[inEdge[current]].from;
-                    }
-                }
-            }else {
-                id[i] = ++numNodes;
-            }
+            return EdmondsStatus::Ok;
         }
 
-        for(auto& edge : edges){
-            int u = id[edge.from]-1;
-            int v = id[edge.to]-1;
-            if (u != v)
-            {
-                int w = edge.weight;
-                w -= edges[inEdge[edge.to]].weight;
-                contractedEdges.push_back({u, v, w});
+        TraceSpan contractSpan("contract");
+        Edge* next = contractedEdges[round % 2];
+        numContracted = 0;
+        int numNodes = numberContractedNodes(n, inFrom, workspace.cycle, id);
+        for (size_t slice = 0; slice < numEdges; slice += SolveStop::STOP_CHECK_EDGES) {
+            if (optional<EdmondsStatus> stopped = checkStop(stop)) return stopped;
+            size_t sliceEnd = min(numEdges, slice + SolveStop::STOP_CHECK_EDGES);
+            for (size_t e = slice; e < sliceEnd; e++) {
+                Edge edge = current[e];
+                if (masked && !masked->allowed(e, edge.to)) continue;
+                int u = id[edge.from]-1;
+                int v = id[edge.to]-1;
+                if (u != v)
+                {
+                    int w = edge.weight;
+                    w -= inWeight[edge.to];
+                    next[numContracted++] = {u, v, w};
+                }
             }
         }
-        edges = contractedEdges;
         n = numNodes;
         root = id[root]-1;
+        return nullopt;
+    };
+
+    optional<EdmondsStatus> status = runRound(edges, 0);
+    for (int round = 1; !status; round++) {
+        status = runRound(span<const Edge>(contractedEdges[(round - 1) % 2], numContracted), round);
+    }
+    solveSpan.arg("cycles", totalCycles);
+    return *status;
+}
+
+/**
+ * @brief chuLiuEdmondsOver for edges stored contiguously as Edge structs.
+ */
+EdmondsStatus chuLiuEdmonds(int n, int root, span<const Edge> edges, EdmondsWorkspace workspace, int& minWeight,
+                            const SolveStop* stop = nullptr, const EdgeConstraints* constraints = nullptr) {
+    return chuLiuEdmondsOver(n, root, edges, workspace, minWeight, stop, constraints);
+}
+
+/**
+ * @brief chuLiuEdmonds with its workspace allocated from a memory resource.
+ *
+ * @param resource The memory resource every scratch buffer of the solve is allocated from.
+ * @return The total weight of the minimum spanning arborescence, or -1 if no arborescence exists.
+ */
+int chuLiuEdmonds(int n, int root, span<const Edge> edges, pmr::memory_resource* resource) {
+    EdmondsWorkspaceSize size = requiredWorkspace(n, edges.size());
+    pmr::vector<int> inFrom(size.nodeInts, resource), inWeight(size.nodeInts, resource);
+    pmr::vector<int> cycle(size.nodeInts, resource), visited(size.nodeInts, resource), id(size.nodeInts, resource);
+    pmr::vector<Edge> edgeScratch(size.scratchEdges, resource);
+    int minWeight;
+    EdmondsStatus status = chuLiuEdmonds(n, root, edges, {inFrom, inWeight, cycle, visited, id, edgeScratch}, minWeight);
+    return status == EdmondsStatus::Ok ? minWeight : -1;
+}
+
+/**
+ * @brief Convenience overload of chuLiuEdmonds that allocates its scratch memory from the default resource.
+ */
+int chuLiuEdmonds(int n, int root, span<const Edge> edges) {
+    return chuLiuEdmonds(n, root, edges, pmr::get_default_resource());
+}
+
+/**
+ * @brief chuLiuEdmonds over the edges constraints allows, forcing the ones it forces.
+ *
+ * @return The total weight of the minimum spanning arborescence, or -1 if no arborescence meets
+ *         the constraints.
+ */
+int chuLiuEdmonds(int n, int root, span<const Edge> edges, const EdgeConstraints& constraints) {
+    EdmondsWorkspaceSize size = requiredWorkspace(n, edges.size());
+    vector<int> inFrom(size.nodeInts), inWeight(size.nodeInts), cycle(size.nodeInts), visited(size.nodeInts);
+    vector<int> id(size.nodeInts);
+    vector<Edge> edgeScratch(size.scratchEdges);
+    int minWeight;
+    EdmondsStatus status = chuLiuEdmonds(n, root, edges, {inFrom, inWeight, cycle, visited, id, edgeScratch},
+                                         minWeight, nullptr, &constraints);
+    return status == EdmondsStatus::Ok ? minWeight : -1;
+}
+
+/**
+ * @brief Upper bound on the scratch bytes one chuLiuEdmonds solve draws from its memory resource.
+ *
+ * The solver makes one allocation per per-node buffer and one for the edge scratch; the bound
+ * adds the worst-case alignment padding a bump allocator can insert before each of them. An arena at
+ * least this large never has to go back to its upstream resource.
+ */
+size_t chuLiuEdmondsScratchBytes(int n, size_t numEdges) {
+    EdmondsWorkspaceSize size = requiredWorkspace(n, numEdges);
+    return EdmondsWorkspace::NODE_ARRAYS * size.nodeInts * sizeof(int) + size.scratchEdges * sizeof(Edge) +
+           (EdmondsWorkspace::NODE_ARRAYS + 1) * alignof(max_align_t);
+}
+
+/**
+ * @brief Runs chuLiuEdmonds with every temporary drawn from a caller-provided bump arena.
+ *
+ * @param arena The arena to allocate from. It is released in one shot after the solve, so it
+ *              must not hold anything the caller still needs.
+ * @param bytesUsed If non-null, receives the number of bytes the solve drew from the arena.
+ * @return The total weight of the minimum spanning arborescence, or -1 if no arborescence exists.
+ */
+int chuLiuEdmondsInArena(int n, int root, span<const Edge> edges, pmr::monotonic_buffer_resource& arena,
+                         size_t* bytesUsed = nullptr) {
+    int result;
+    {
+        CountingMemoryResource counter(&arena);
+        result = chuLiuEdmonds(n, root, edges, &counter);
+        if (bytesUsed) *bytesUsed = counter.bytesAllocated();
+    }
+    arena.release();
+    return result;
+}
+
+/**
+ * @brief Runs chuLiuEdmonds in a one-off arena: on the stack when the graph is small enough,
+ * otherwise in a single heap block pre-sized with chuLiuEdmondsScratchBytes.
+ */
+int chuLiuEdmondsInArena(int n, int root, span<const Edge> edges, size_t* bytesUsed = nullptr) {
+    const size_t STACK_ARENA_BYTES = 16 * 1024;
+    size_t needed = chuLiuEdmondsScratchBytes(n, edges.size());
+    if (needed <= STACK_ARENA_BYTES) {
+        alignas(max_align_t) byte stackBuffer[STACK_ARENA_BYTES];
+        pmr::monotonic_buffer_resource arena(stackBuffer, sizeof(stackBuffer));
+        return chuLiuEdmondsInArena(n, root, edges, arena, bytesUsed);
+    }
+    pmr::monotonic_buffer_resource arena(needed);
+    return chuLiuEdmondsInArena(n, root, edges, arena, bytesUsed);
+}
+
+/**
+ * @brief Union-find with union by size and no path compression, so that joins can be undone
+ * in reverse order.
+ */
+class RollbackUnionFind {
+public:
+    explicit RollbackUnionFind(int n) : parentOrSize(n, -1) {}
+
+    int find(int x) const {
+        while (parentOrSize[x] >= 0) x = parentOrSize[x];
+        return x;
+    }
+
+    /**
+     * @brief Joins the sets of a and b.
+     *
+     * @return false if they were already one set.
+     */
+    bool join(int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return false;
+        if (parentOrSize[a] > parentOrSize[b]) swap(a, b);
+        history.push_back({a, parentOrSize[a]});
+        history.push_back({b, parentOrSize[b]});
+        parentOrSize[a] += parentOrSize[b];
+        parentOrSize[b] = a;
+        return true;
+    }
+
+    int time() const { return history.size(); }
+
+    /**
+     * @brief Undoes every join made after time() returned t.
+     */
+    void rollback(int t) {
+        for (int i = time(); i-- > t;) parentOrSize[history[i].first] = history[i].second;
+        history.resize(t);
+    }
+
+private:
+    vector<int> parentOrSize;      // parent, or minus the set size for a representative
+    vector<pair<int, int>> history;
+};
+
+/**
+ * @brief A forest of skew heaps over the edges of a graph, ordered by weight, where adding a
+ * constant to every weight of a heap is O(1).
+ */
+class EdgeSkewHeaps {
+public:
+    explicit EdgeSkewHeaps(span<const Edge> edges) : nodes(edges.size()) {
+        for (size_t e = 0; e < edges.size(); e++) {
+            nodes[e] = {edges[e].weight, 0, -1, -1};
+        }
+    }
+
+    /**
+     * @brief Melds two heaps given by their roots (-1 for an empty heap) and returns the new root.
+     */
+    int merge(int a, int b) {
+        int root = -1;
+        int* link = &root;
+        spine.clear();
+        while (a >= 0 && b >= 0) {
+            push(a);
+            push(b);
+            if (nodes[b].weight < nodes[a].weight) swap(a, b);
+            *link = a;
+            spine.push_back(a);
+            link = &nodes[a].right;
+            a = nodes[a].right;
+        }
+        *link = a >= 0 ? a : b;
+        for (int node : spine) swap(nodes[node].left, nodes[node].right);
+        return root;
+    }
+
+    /**
+     * @brief The weight of the root edge, with every pending offset applied.
+     */
+    long long top(int root) {
+        push(root);
+        return nodes[root].weight;
+    }
+
+    /**
+     * @brief Adds delta to every weight in the heap.
+     */
+    void add(int root, long long delta) { nodes[root].delta += delta; }
+
+    /**
+     * @brief Removes the root edge and returns the root of the remaining heap.
+     */
+    int pop(int root) {
+        push(root);
+        return merge(nodes[root].left, nodes[root].right);
+    }
+
+private:
+    struct Node {
+        long long weight, delta;   // delta is still owed to the node's whole subtree
+        int left, right;
+    };
+
+    void push(int node) {
+        Node& current = nodes[node];
+        if (current.delta == 0) return;
+        current.weight += current.delta;
+        if (current.left >= 0) nodes[current.left].delta += current.delta;
+        if (current.right >= 0) nodes[current.right].delta += current.delta;
+        current.delta = 0;
+    }
+
+    vector<Node> nodes;
+    vector<int> spine;
+};
+
+/**
+ * @brief The contraction hierarchy of a solve together with its linear programming dual.
+ *
+ * Super-nodes 0..n-1 are the single nodes; every cycle contracted during the solve adds one more,
+ * enclosing the super-nodes on the cycle, so the super-nodes form a laminar family of node sets.
+ * dual[s] is the total weight subtracted from the edges entering s while s was a component.
+ *
+ * The arborescence given by inEdge is optimal because the duals certify it: no edge has negative
+ * reduced weight, the weight minus the duals of the super-nodes it enters, and every arborescence
+ * edge has reduced weight zero. The total weight equals the sum of all duals.
+ */
+struct ArborescenceDuals {
+    vector<int> up;         // enclosing super-node, or -1 for the outermost ones
+    vector<int> depth;      // number of super-nodes enclosing this one
+    vector<long long> dual;
+    vector<int> inEdge;     // for each node, the index of its edge in the arborescence (-1 for the root)
+
+    /**
+     * @brief The sum of the duals of the super-nodes that contain `to` but not `from`, walking
+     *        both chains up to their lowest common super-node; O(depth).
+     */
+    long long enteredDual(int from, int to) const {
+        long long sum = 0;
+        int a = to, b = from;
+        while (a != b) {
+            int depthA = a < 0 ? -1 : depth[a];
+            int depthB = b < 0 ? -1 : depth[b];
+            if (depthA >= depthB) {
+                sum += dual[a];
+                a = up[a];
+            } else {
+                b = up[b];
+            }
+        }
+        return sum;
+    }
+};
+
+/**
+ * @brief Tarjan's O(E log V) implementation of Chu-Liu-Edmonds.
+ *
+ * Instead of rebuilding the graph each round, the in-edges of every (contracted) node live in a
+ * mergeable heap. Following minimum in-edges backwards from each node until the root is reached
+ * finds cycles one at a time; a cycle is contracted by melding its heaps, after subtracting from
+ * each heap the weight of the in-edge it chose. The contractions are recorded in a rollback
+ * union-find, so that the chosen edges can be expanded into the arborescence afterwards.
+ *
+ * @param minWeight Receives the total weight of the minimum spanning arborescence on success.
+ * @param parent If non-null, receives for each node the source of its edge in the arborescence
+ *               (-1 for the root).
+ * @param stop If non-null, checked every SolveStop::STOP_CHECK_EDGES heap operations.
+ * @param duals If non-null, receives the contraction hierarchy and its dual values on success.
+ * @param constraints If non-null, only the edges it allows are put into the heaps.
+ * @param rootPenalty Added to the weight of every edge leaving the root while solving; minWeight
+ *                    leaves it out again, the duals keep it. The caller keeps it small enough
+ *                    that the penalised weights fit in a long long.
+ * @return EdmondsStatus::Ok, NoArborescence, InvalidArgument, or Cancelled / TimedOut if stopped.
+ */
+EdmondsStatus chuLiuEdmondsTarjan(int n, int root, span<const Edge> edges, int& minWeight,
+                                  vector<int>* parent = nullptr, const SolveStop* stop = nullptr,
+                                  ArborescenceDuals* duals = nullptr, const EdgeConstraints* constraints = nullptr,
+                                  long long rootPenalty = 0) {
+    if (n <= 0 || root < 0 || root >= n) return EdmondsStatus::InvalidArgument;
+    for (const Edge& edge : edges) {
+        if (edge.from < 0 || edge.from >= n || edge.to < 0 || edge.to >= n) return EdmondsStatus::InvalidArgument;
+    }
+    if (constraints && !constraints->fits(n, edges.size())) return EdmondsStatus::InvalidArgument;
+    if (constraints && !constraints->consistent(root)) return EdmondsStatus::NoArborescence;
+    TraceSpan solveSpan("chuLiuEdmondsTarjan");
+    solveSpan.arg("n", n);
+    solveSpan.arg("E", (long long)edges.size());
+
+    // heap holds for each component the root of the heap of edges entering it
+    // seen marks the start node of the walk that reached a component, or -1
+    // path and chosen hold the components of the current walk and the edges chosen into them
+    // in holds for each component the edge entering it in the final arborescence
+    EdgeSkewHeaps heaps(edges);
+    vector<int> heap(n, -1);
+    for (size_t e = 0; e < edges.size(); e++) {
+        if (e % SolveStop::STOP_CHECK_EDGES == 0) {
+            if (optional<EdmondsStatus> stopped = checkStop(stop)) return *stopped;
+        }
+        int to = edges[e].to;
+        if (constraints && !constraints->allowed(e, to)) continue;
+        if (rootPenalty && edges[e].from == root) heaps.add(e, rootPenalty);
+        heap[to] = heaps.merge(heap[to], e);
+    }
+    RollbackUnionFind components(n);
+    vector<int> seen(n, -1), path(n), chosen(n), in(n, -1);
+    struct Contraction {
+        int component, time;
+        vector<int> cycleEdges;
+    };
+    deque<Contraction> contractions;
+    long long total = 0;
+    size_t pops = 0;
+    seen[root] = root;
+    // superOf maps a component representative to its super-node in duals
+    vector<int> superOf;
+    if (duals) {
+        superOf.resize(n);
+        iota(superOf.begin(), superOf.end(), 0);
+        duals->up.assign(n, -1);
+        duals->dual.assign(n, 0);
+    }
+
+    for (int start = 0; start < n; start++) {
+        int u = start, length = 0;
+        while (seen[u] < 0) {
+            if (heap[u] < 0) return EdmondsStatus::NoArborescence;
+            if (++pops % SolveStop::STOP_CHECK_EDGES == 0) {
+                if (optional<EdmondsStatus> stopped = checkStop(stop)) return *stopped;
+            }
+            int e = heap[u];
+            long long weight = heaps.top(e);
+            heaps.add(e, -weight);
+            heap[u] = heaps.pop(e);
+            chosen[length] = e;
+            path[length++] = u;
+            seen[u] = start;
+            total += weight;
+            if (duals) duals->dual[superOf[u]] += weight;
+            u = components.find(edges[e].from);
+            if (seen[u] == start) {
+                int merged = -1, end = length, time = components.time(), w;
+                // a self-loop only lowers the heap; it does not enclose anything new
+                int super = -1;
+                if (duals && path[length - 1] != u) {
+                    super = (int)duals->up.size();
+                    duals->up.push_back(-1);
+                    duals->dual.push_back(0);
+                }
+                do {
+                    w = path[--length];
+                    merged = heaps.merge(merged, heap[w]);
+                    if (super >= 0) duals->up[superOf[w]] = super;
+                } while (components.join(u, w));
+                u = components.find(u);
+                if (super >= 0) superOf[u] = super;
+                heap[u] = merged;
+                seen[u] = -1;
+                contractions.push_front({u, time, vector<int>(chosen.begin() + length, chosen.begin() + end)});
+            }
+        }
+        for (int i = 0; i < length; i++) {
+            in[components.find(edges[chosen[i]].to)] = chosen[i];
+        }
+    }
+
+    for (const Contraction& contraction : contractions) {
+        components.rollback(contraction.time);
+        int inEdge = in[contraction.component];
+        for (int e : contraction.cycleEdges) in[components.find(edges[e].to)] = e;
+        in[components.find(edges[inEdge].to)] = inEdge;
+    }
+    if (parent) {
+        parent->assign(n, -1);
+        for (int v = 0; v < n; v++) {
+            if (v != root) (*parent)[v] = edges[in[v]].from;
+        }
+    }
+    if (duals) {
+        in[root] = -1;
+        duals->inEdge = in;
+        // a super-node is created after everything it encloses
+        duals->depth.assign(duals->up.size(), 0);
+        for (size_t s = duals->up.size(); s-- > 0;) {
+            if (duals->up[s] >= 0) duals->depth[s] = duals->depth[duals->up[s]] + 1;
+        }
+    }
+    for (int v = 0; v < n && rootPenalty; v++) {
+        if (v != root && edges[in[v]].from == root) total -= rootPenalty;
+    }
+    minWeight = total;
+    return EdmondsStatus::Ok;
+}
+
+/**
+ * @brief A minimum spanning arborescence that is kept up to date as edges are inserted, removed or
+ *        reweighted.
+ *
+ * The contraction hierarchy and duals of the last solve are kept. An update that leaves every
+ * reduced weight non-negative leaves the arborescence optimal, so it is answered by walking the
+ * super-nodes enclosing the edge's endpoints, O(depth) instead of O(E log V). A cheaper
+ * arborescence edge only lowers the dual of its target, and a dearer one raises it as long as the
+ * other edges into the target have the slack.
+ *
+ * Any other update is repaired inside the smallest super-node S enclosing both endpoints of the
+ * edge: the graph induced by S is solved again from the node where the arborescence enters S, and
+ * the new hierarchy replaces the old one inside S. That is only kept if the duals outside S still
+ * certify it, i.e. no edge entering S becomes cheaper to enter by; otherwise the next enclosing
+ * super-node is tried, and in the end the whole graph. A whole-graph solve is deferred to the next
+ * query, so that a burst of updates between two queries costs at most one.
+ */
+class DynamicArborescence {
+public:
+    DynamicArborescence(int n, int root, vector<Edge> edges)
+        : n(n), root(root), edges(std::move(edges)), removed(this->edges.size(), false), inEdges(max(n, 0)) {
+        for (size_t e = 0; e < this->edges.size(); e++) {
+            int to = this->edges[e].to;
+            if (to >= 0 && to < n) inEdges[to].push_back((int)e);
+        }
+        resolve();
+    }
+
+    /**
+     * @brief Inserts the edge and returns its index, which stays valid for later updates, or -1 if
+     *        an endpoint is out of range.
+     */
+    int addEdge(int from, int to, int weight) {
+        if (from < 0 || from >= n || to < 0 || to >= n) return -1;
+        int index = (int)edges.size();
+        edges.push_back({from, to, weight});
+        removed.push_back(false);
+        inEdges[to].push_back(index);
+        if (!certified()) {
+            if (from != to && to != root) stale = true;
+            fastUpdates++;
+        } else if (from == to || to == root || weight - duals.enteredDual(from, to) >= 0) {
+            fastUpdates++;
+        } else {
+            repair(from, to);
+        }
+        return index;
+    }
+
+    /**
+     * @brief Removes the edge at index; the indices of the other edges do not change.
+     * @return false, changing nothing, if there is no such edge.
+     */
+    bool removeEdge(int index) {
+        if (!isEdge(index)) return false;
+        const Edge& edge = edges[index];
+        removed[index] = true;
+        vector<int>& into = inEdges[edge.to];
+        into.erase(find(into.begin(), into.end(), index));
+        if (!certified() || duals.inEdge[edge.to] != index) {
+            fastUpdates++;
+        } else {
+            total -= edge.weight;
+            duals.inEdge[edge.to] = -1;
+            repair(edge.from, edge.to);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Lowers the weight of the edge at index to weight.
+     * @return false, changing nothing, if there is no such edge or weight exceeds its current weight.
+     */
+    bool decreaseWeight(int index, int weight) {
+        if (!isEdge(index) || weight > edges[index].weight) return false;
+        Edge& edge = edges[index];
+        int delta = edge.weight - weight;
+        edge.weight = weight;
+        if (!certified() || edge.from == edge.to || edge.to == root) {
+            fastUpdates++;
+        } else if (duals.inEdge[edge.to] == index) {
+            duals.dual[edge.to] -= delta;
+            total -= delta;
+            fastUpdates++;
+        } else if (weight - duals.enteredDual(edge.from, edge.to) >= 0) {
+            fastUpdates++;
+        } else {
+            repair(edge.from, edge.to);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Raises the weight of the edge at index to weight.
+     * @return false, changing nothing, if there is no such edge or weight is below its current weight.
+     */
+    bool increaseWeight(int index, int weight) {
+        if (!isEdge(index) || weight < edges[index].weight) return false;
+        Edge& edge = edges[index];
+        int delta = weight - edge.weight;
+        edge.weight = weight;
+        if (!certified() || duals.inEdge[edge.to] != index) {
+            fastUpdates++;
+            return true;
+        }
+        total += delta;
+        bool slack = true;
+        for (int e : inEdges[edge.to]) {
+            const Edge& other = edges[e];
+            if (e != index && other.from != other.to &&
+                other.weight - duals.enteredDual(other.from, other.to) < delta) {
+                slack = false;
+                break;
+            }
+        }
+        if (slack) {
+            duals.dual[edge.to] += delta;
+            fastUpdates++;
+        } else {
+            repair(edge.from, edge.to);
+        }
+        return true;
+    }
+
+    EdmondsStatus status() {
+        refresh();
+        return currentStatus;
+    }
+
+    /**
+     * @brief The weight of the current minimum spanning arborescence; valid when status() is Ok.
+     */
+    int minWeight() {
+        refresh();
+        return (int)total;
+    }
+
+    /**
+     * @brief For each node, the source of its edge in the current arborescence (-1 for the root).
+     */
+    const vector<int>& parents() {
+        refresh();
+        return parent;
+    }
+
+    /**
+     * @brief All edges by index, including removed ones; see isRemoved.
+     */
+    span<const Edge> edgeList() const { return edges; }
+
+    bool isRemoved(int index) const { return removed[index]; }
+
+    size_t fastUpdateCount() const { return fastUpdates; }
+    size_t localResolveCount() const { return localResolves; }
+    size_t resolveCount() const { return resolves; }
+
+private:
+    bool isEdge(int index) const { return index >= 0 && (size_t)index < edges.size() && !removed[index]; }
+
+    /**
+     * @brief Whether the hierarchy and duals describe the current graph, so updates can be checked
+     *        against them.
+     */
+    bool certified() const { return !stale && currentStatus == EdmondsStatus::Ok; }
+
+    void refresh() {
+        if (stale) resolve();
+    }
+
+    /**
+     * @brief Solves the whole graph from scratch.
+     */
+    void resolve() {
+        vector<Edge> live;
+        vector<int> indices;
+        for (size_t e = 0; e < edges.size(); e++) {
+            if (removed[e]) continue;
+            live.push_back(edges[e]);
+            indices.push_back((int)e);
+        }
+        int weight = 0;
+        currentStatus = chuLiuEdmondsTarjan(n, root, live, weight, &parent, nullptr, &duals);
+        total = weight;
+        stale = false;
+        resolves++;
+        if (currentStatus != EdmondsStatus::Ok) return;
+        for (int& e : duals.inEdge) {
+            if (e >= 0) e = indices[e];
+        }
+        size_t count = duals.up.size();
+        first.assign(count, 0);
+        last.assign(count, 0);
+        order.assign(n, 0);
+        position.assign(n, 0);
+        vector<int> tops;
+        for (size_t s = 0; s < count; s++) {
+            if (duals.up[s] < 0) tops.push_back((int)s);
+        }
+        layout(tops, duals.up, [](int s) { return s; }, 0);
+    }
+
+    /**
+     * @brief Lays out the given super-nodes and everything inside them from order[offset] on, so
+     *        that the nodes inside every super-node s are order[first[s]..last[s]).
+     *
+     * up describes the hierarchy to lay out and global maps its super-nodes to those of duals.
+     */
+    template <class Global>
+    void layout(const vector<int>& tops, const vector<int>& up, const Global& global, int offset) {
+        size_t count = up.size();
+        vector<int> childStart(count + 1, 0), children(count);
+        for (size_t s = 0; s < count; s++) {
+            if (up[s] >= 0) childStart[up[s] + 1]++;
+        }
+        partial_sum(childStart.begin(), childStart.end(), childStart.begin());
+        vector<int> fill(childStart.begin(), childStart.end() - 1);
+        for (size_t s = 0; s < count; s++) {
+            if (up[s] >= 0) children[fill[up[s]]++] = (int)s;
+        }
+        // ~s on the stack marks leaving s
+        vector<int> stack(tops.rbegin(), tops.rend());
+        while (!stack.empty()) {
+            int s = stack.back();
+            stack.pop_back();
+            if (s < 0) {
+                last[global(~s)] = offset;
+                continue;
+            }
+            int g = global(s);
+            first[g] = offset;
+            if (g < n) {
+                order[offset] = g;
+                position[g] = offset++;
+                last[g] = offset;
+                continue;
+            }
+            stack.push_back(~s);
+            for (int c = childStart[s + 1]; c-- > childStart[s];) stack.push_back(children[c]);
+        }
+    }
+
+    /**
+     * @brief Restores optimality after the edge from -> to changed, solving as small a part of the
+     *        graph again as possible.
+     */
+    void repair(int from, int to) {
+        // the lowest super-node enclosing both endpoints
+        int a = to, b = from;
+        while (a != b) {
+            int depthA = a < 0 ? -1 : duals.depth[a];
+            int depthB = b < 0 ? -1 : duals.depth[b];
+            if (depthA >= depthB) a = duals.up[a];
+            else b = duals.up[b];
+        }
+        // each attempt must at least double the size of the last, so that failed attempts cost
+        // no more than the one that succeeds
+        int tried = 0;
+        for (int s = a; s >= 0; s = duals.up[s]) {
+            int size = last[s] - first[s];
+            if (size < 2 * tried) continue;
+            if (2 * size > n) break;
+            if (resolveWithin(s)) {
+                localResolves++;
+                // replaced super-nodes are left behind; start over before they pile up
+                if (duals.up.size() > 4 * (size_t)n) stale = true;
+                return;
+            }
+            tried = size;
+        }
+        stale = true;
+    }
+
+    /**
+     * @brief Solves the graph induced by super-node s again from the node where the arborescence
+     *        enters s, and installs the result if the duals outside s still certify it.
+     */
+    bool resolveWithin(int s) {
+        int lo = first[s], k = last[s] - lo;
+        auto inside = [&](int v) { return position[v] >= lo && position[v] < lo + k; };
+        vector<Edge> local;
+        vector<int> indices;
+        // the least reduced weight of the edges from outside s into each node inside it
+        vector<long long> entrySlack(k, LLONG_MAX);
+        int entry = -1;
+        for (int i = 0; i < k; i++) {
+            int x = order[lo + i];
+            int e = duals.inEdge[x];
+            if (e >= 0 && !inside(edges[e].from)) {
+                if (entry >= 0) return false;
+                entry = i;
+            }
+            for (int f : inEdges[x]) {
+                if (inside(edges[f].from)) {
+                    local.push_back({position[edges[f].from] - lo, i, edges[f].weight});
+                    indices.push_back(f);
+                } else {
+                    entrySlack[i] = min(entrySlack[i], edges[f].weight - duals.enteredDual(edges[f].from, x));
+                }
+            }
+        }
+        if (entry < 0) return false;
+        int weight = 0;
+        ArborescenceDuals inner;
+        if (chuLiuEdmondsTarjan(k, entry, local, weight, nullptr, nullptr, &inner) != EdmondsStatus::Ok) return false;
+
+        // An edge entering s at x sees its reduced weight change by the drop in x's potential, the
+        // sum of the duals enclosing x inside s; it must stay non-negative. Part of the potentials
+        // can be moved onto s itself (shift), as long as its dual stays non-negative; the entry
+        // node keeps its potential, so that the edge entering s still has reduced weight zero.
+        vector<long long> innerPotential(inner.up.size());
+        for (size_t t = inner.up.size(); t-- > 0;) {
+            innerPotential[t] = inner.dual[t] + (inner.up[t] < 0 ? 0 : innerPotential[inner.up[t]]);
+        }
+        auto outerPotential = [&](int x) {
+            long long sum = 0;
+            for (int t = x; t != s; t = duals.up[t]) sum += duals.dual[t];
+            return sum;
+        };
+        long long entryPotential = outerPotential(order[lo + entry]);
+        long long highest = LLONG_MAX, lowest = -duals.dual[s];
+        for (int i = 0; i < k; i++) {
+            if (i != entry && entrySlack[i] != LLONG_MAX) {
+                highest = min(highest, entrySlack[i] + outerPotential(order[lo + i]) - innerPotential[i]);
+            }
+        }
+        for (const Edge& edge : local) {
+            if (edge.to == entry && edge.from != entry) lowest = max(lowest, entryPotential - edge.weight);
+        }
+        if (lowest > highest) return false;
+        long long shift = highest == LLONG_MAX ? lowest : highest;
+
+        vector<int> global(inner.up.size());
+        for (int i = 0; i < k; i++) global[i] = order[lo + i];
+        for (size_t t = k; t < inner.up.size(); t++) {
+            global[t] = (int)duals.up.size();
+            duals.up.push_back(-1);
+            duals.depth.push_back(0);
+            duals.dual.push_back(0);
+            first.push_back(0);
+            last.push_back(0);
+        }
+        for (size_t t = inner.up.size(); t-- > 0;) {
+            int g = global[t], up = inner.up[t] < 0 ? s : global[inner.up[t]];
+            duals.up[g] = up;
+            duals.depth[g] = duals.depth[up] + 1;
+            duals.dual[g] = inner.dual[t];
+        }
+        int entryNode = order[lo + entry];
+        duals.dual[entryNode] = entryPotential - shift;
+        duals.dual[s] += shift;
+        for (int i = 0; i < k; i++) {
+            if (i == entry) continue;
+            int x = order[lo + i];
+            if (duals.inEdge[x] >= 0) total -= edges[duals.inEdge[x]].weight;
+            int e = indices[inner.inEdge[i]];
+            total += edges[e].weight;
+            duals.inEdge[x] = e;
+            parent[x] = edges[e].from;
+        }
+        vector<int> tops;
+        for (size_t t = 0; t < inner.up.size(); t++) {
+            if (inner.up[t] < 0) tops.push_back((int)t);
+        }
+        layout(tops, inner.up, [&](int t) { return global[t]; }, lo);
+        return true;
+    }
+
+    int n, root;
+    vector<Edge> edges;
+    vector<bool> removed;
+    vector<vector<int>> inEdges;  // indices of the edges into each node, removed ones excluded
+    EdmondsStatus currentStatus = EdmondsStatus::NoArborescence;
+    bool stale = false;           // the graph changed in a way that needs it solved again
+    long long total = 0;
+    vector<int> parent;
+    ArborescenceDuals duals;      // inEdge holds indices into edges
+    // the nodes inside super-node s are order[first[s]..last[s]), and position inverts order
+    vector<int> order, position, first, last;
+    size_t fastUpdates = 0, localResolves = 0, resolves = 0;
+};
+
+/**
+ * @brief The solution of one solve, handed to the next solve of a slowly changing graph.
+ */
+struct WarmStart {
+    vector<int> parent;
+    ArborescenceDuals duals;
+};
+
+/**
+ * @brief Solves a graph that differs little from the last one solved with warm, reusing its
+ *        contraction hierarchy when it still fits, and otherwise solving cold with chuLiuEdmondsTarjan.
+ *
+ * With the old hierarchy fixed, every super-node's dual is the cheapest reduced weight entering it,
+ * which one pass over the edges finds for all levels at once: an edge is recorded at the highest
+ * super-node it enters, O(depth), and the levels below take suffix minima. The hierarchy still
+ * fits if the cheapest edges into the members of every super-node form a single cycle through them
+ * and those into the outermost super-nodes form a tree under the root. The duals then certify the
+ * expanded arborescence just as after a cold solve, so the weight is the same, although ties may be
+ * broken differently; ties are broken towards the previous parents to keep the hierarchy fitting.
+ *
+ * @param warm The previous solution on entry, or empty; receives the new solution on success.
+ * @param reused If non-null, receives whether the old hierarchy was reused.
+ * @return As chuLiuEdmondsTarjan.
+ */
+EdmondsStatus chuLiuEdmondsWarm(int n, int root, span<const Edge> edges, WarmStart& warm, int& minWeight,
+                                bool* reused = nullptr) {
+    if (reused) *reused = false;
+    auto solveCold = [&] {
+        int weight = 0;
+        EdmondsStatus status = chuLiuEdmondsTarjan(n, root, edges, weight, &warm.parent, nullptr, &warm.duals);
+        if (status == EdmondsStatus::Ok) minWeight = weight;
+        else warm = {};
+        return status;
+    };
+    const vector<int>& up = warm.duals.up;
+    const vector<int>& depth = warm.duals.depth;
+    int count = (int)up.size();
+    if (n <= 0 || root < 0 || root >= n || warm.parent.size() != (size_t)n || count < n ||
+        depth.size() != up.size() || up[root] != -1) {
+        return solveCold();
+    }
+    // super-nodes must come after everything they enclose, as chuLiuEdmondsTarjan numbers them
+    for (int s = 0; s < count; s++) {
+        if (up[s] >= 0 && (up[s] <= s || up[s] < n || up[s] >= count)) return solveCold();
+    }
+    for (const Edge& edge : edges) {
+        if (edge.from < 0 || edge.from >= n || edge.to < 0 || edge.to >= n) return EdmondsStatus::InvalidArgument;
+    }
+    TraceSpan solveSpan("chuLiuEdmondsWarm");
+    solveSpan.arg("n", n);
+    solveSpan.arg("E", (long long)edges.size());
+
+    // lay the nodes out so that those inside super-node s are order[first[s]..first[s] + size[s]);
+    // a super-node's number is larger than those of everything inside it
+    vector<int> size(count, 0), first(count, 0), order(n), childCount(count, 0), someChild(count, -1);
+    int maxDepth = 0;
+    for (int s = 0; s < count; s++) {
+        if (s < n) size[s] = 1;
+        maxDepth = max(maxDepth, depth[s]);
+        if (up[s] >= 0) {
+            size[up[s]] += size[s];
+            childCount[up[s]]++;
+            someChild[up[s]] = s;
+        }
+    }
+    {
+        vector<int> cursor(count);
+        int offset = 0;
+        for (int s = count - 1; s >= 0; s--) {
+            if (up[s] < 0) {
+                first[s] = offset;
+                offset += size[s];
+            } else {
+                first[s] = cursor[up[s]];
+                cursor[up[s]] += size[s];
+            }
+            cursor[s] = first[s];
+            if (s < n) order[first[s]] = s;
+        }
+    }
+    auto contains = [&](int s, int x) { return first[s] <= first[x] && first[x] < first[s] + size[s]; };
+    // jump[k * count + s] is the 2^k-th super-node enclosing s, or -1
+    int levels = bit_width((unsigned)maxDepth);
+    vector<int> jump((size_t)max(levels, 1) * count);
+    copy(up.begin(), up.end(), jump.begin());
+    for (int k = 1; k < levels; k++) {
+        for (int s = 0; s < count; s++) {
+            int half = jump[(size_t)(k - 1) * count + s];
+            jump[(size_t)k * count + s] = half < 0 ? -1 : jump[(size_t)(k - 1) * count + half];
+        }
+    }
+    // the super-node enclosing x at the given depth
+    auto enclosing = [&](int x, int atDepth) {
+        for (int k = 0, steps = depth[x] - atDepth; steps > 0; k++, steps >>= 1) {
+            if (steps & 1) x = jump[(size_t)k * count + x];
+        }
+        return x;
+    };
+    // The lowest super-node enclosing the nodes at two positions of order is the shallowest of
+    // those enclosing neighbouring positions in between, so a sparse table over the depths of the
+    // latter (-1 where nothing encloses both) answers it in O(1).
+    int rows = bit_width((unsigned)max(n - 1, 1));
+    vector<int> sharedDepth((size_t)rows * max(n - 1, 1), -1);
+    for (int i = 0; i + 1 < n; i++) {
+        int a = order[i], b = order[i + 1];
+        if (depth[a] > depth[b]) a = enclosing(a, depth[b]);
+        else b = enclosing(b, depth[a]);
+        for (int k = levels - 1; k >= 0; k--) {
+            int upA = jump[(size_t)k * count + a], upB = jump[(size_t)k * count + b];
+            if (upA != upB) {
+                a = upA;
+                b = upB;
+            }
+        }
+        sharedDepth[i] = a == b ? depth[a] : up[a] == up[b] && up[a] >= 0 ? depth[up[a]] : -1;
+    }
+    for (int k = 1; k < rows; k++) {
+        for (int i = 0; i + (1 << k) <= n - 1; i++) {
+            sharedDepth[(size_t)k * (n - 1) + i] = min(sharedDepth[(size_t)(k - 1) * (n - 1) + i],
+                                                       sharedDepth[(size_t)(k - 1) * (n - 1) + i + (1 << (k - 1))]);
+        }
+    }
+    auto lowestSharedDepth = [&](int x, int y) {
+        int lo = min(first[x], first[y]), hi = max(first[x], first[y]);
+        int k = bit_width((unsigned)(hi - lo)) - 1;
+        return min(sharedDepth[(size_t)k * (n - 1) + lo], sharedDepth[(size_t)k * (n - 1) + hi - (1 << k)]);
+    };
+
+    // slots[slotStart[x] + j] holds the cheapest edge into x from outside the j-th super-node
+    // enclosing x (the 0th being x itself), and the highest level that edge enters
+    struct Slot {
+        int weight, edge = -1, top;
+    };
+    vector<int> slotStart(n + 1, 0);
+    for (int x = 0; x < n; x++) slotStart[x + 1] = slotStart[x] + depth[x] + 1;
+    vector<Slot> slots(slotStart[n]);
+    // ties go to the edge entering the fewest super-nodes beyond the one it is chosen for, so
+    // that the cheapest edges into the members of a super-node stay inside it, and then to the
+    // previous parent
+    auto better = [&](long long weight, int beyond, int e, long long bestWeight, int bestBeyond, int bestEdge) {
+        if (bestEdge < 0 || weight != bestWeight) return bestEdge < 0 || weight < bestWeight;
+        if (beyond != bestBeyond) return beyond < bestBeyond;
+        return edges[e].from == warm.parent[edges[e].to] && edges[bestEdge].from != warm.parent[edges[bestEdge].to];
+    };
+    for (size_t e = 0; e < edges.size(); e++) {
+        const Edge& edge = edges[e];
+        if (edge.from == edge.to || edge.to == root) continue;
+        int top = depth[edge.to] - lowestSharedDepth(edge.from, edge.to) - 1;
+        Slot& slot = slots[slotStart[edge.to] + top];
+        if (better(edge.weight, 0, (int)e, slot.weight, 0, slot.edge)) slot = {edge.weight, (int)e, top};
+    }
+    for (int x = 0; x < n; x++) {
+        for (int j = depth[x] - 1; j >= 0; j--) {
+            Slot& slot = slots[slotStart[x] + j];
+            const Slot& above = slots[slotStart[x] + j + 1];
+            if (above.edge >= 0 && better(above.weight, above.top - j, above.edge, slot.weight, slot.top - j, slot.edge)) {
+                slot = above;
+            }
+        }
+    }
+
+    // duals inside out; potential[x] sums the duals of the super-nodes enclosing x so far
+    vector<long long> dual(count, 0), potential(n, 0);
+    vector<int> level(n, 0), cheapest(count, -1);
+    for (int s = 0; s < count; s++) {
+        if (s == root) continue;
+        long long best = LLONG_MAX;
+        int bestBeyond = 0;
+        for (int i = first[s]; i < first[s] + size[s]; i++) {
+            int x = order[i];
+            const Slot& slot = slots[slotStart[x] + level[x]];
+            if (slot.edge < 0) continue;
+            long long reduced = slot.weight - potential[x];
+            int beyond = slot.top - level[x];
+            if (better(reduced, beyond, slot.edge, best, bestBeyond, cheapest[s])) {
+                best = reduced;
+                bestBeyond = beyond;
+                cheapest[s] = slot.edge;
+            }
+        }
+        if (cheapest[s] < 0) return solveCold();
+        dual[s] = best;
+        for (int i = first[s]; i < first[s] + size[s]; i++) {
+            potential[order[i]] += best;
+            level[order[i]]++;
+        }
+    }
+
+    // the cheapest edges into the members of a super-node must run around a single cycle
+    vector<int> next(count, -1);
+    for (int s = 0; s < count; s++) {
+        if (up[s] < 0) continue;
+        int from = edges[cheapest[s]].from;
+        if (!contains(up[s], from) || contains(s, from)) return solveCold();
+        next[s] = enclosing(from, depth[s]);
+    }
+    for (int s = n; s < count; s++) {
+        int steps = 0, child = someChild[s];
+        do {
+            child = next[child];
+            steps++;
+        } while (child != someChild[s] && steps <= childCount[s]);
+        if (steps != childCount[s]) return solveCold();
+    }
+    // and those into the outermost super-nodes must hang off the root without cycles
+    vector<int> state(count, 0);
+    state[root] = 2;
+    for (int s = 0; s < count; s++) {
+        if (up[s] >= 0 || state[s] != 0) continue;
+        int t = s;
+        while (state[t] == 0) {
+            state[t] = 1;
+            next[t] = enclosing(edges[cheapest[t]].from, 0);
+            t = next[t];
+        }
+        if (state[t] == 1) return solveCold();
+        for (t = s; state[t] == 1; t = next[t]) state[t] = 2;
+    }
+
+    // expand: each super-node is entered by its own cheapest edge unless its parent is entered
+    // through it
+    vector<int> enter(count, -1);
+    for (int s = count - 1; s >= 0; s--) {
+        if (s == root) continue;
+        if (up[s] < 0) enter[s] = cheapest[s];
+        else enter[s] = contains(s, edges[enter[up[s]]].to) ? enter[up[s]] : cheapest[s];
+    }
+    long long total = 0;
+    for (int x = 0; x < n; x++) {
+        warm.parent[x] = x == root ? -1 : edges[enter[x]].from;
+        if (x != root) total += edges[enter[x]].weight;
+    }
+    enter.resize(n);
+    warm.duals.inEdge = std::move(enter);
+    warm.duals.dual = std::move(dual);
+    minWeight = total;
+    if (reused) *reused = true;
+    return EdmondsStatus::Ok;
+}
+
+/**
+ * @brief One of the k best arborescences: its weight, and for each node its parent and the index
+ *        of its edge (-1 for the root).
+ */
+struct RankedArborescence {
+    int total;
+    vector<int> parent;
+    vector<int> inEdge;
+};
+
+/**
+ * @brief Enumerates the k minimum spanning arborescences in order of weight.
+ *
+ * The solutions are partitioned as Sörensen and Janssens do: a subproblem forces some edges in and
+ * keeps others out, and once its best arborescence t1..tm (free edges only) is reported, child j
+ * forces t1..t(j-1) and excludes tj. Children are kept in a priority queue and only solved when
+ * they reach its front.
+ *
+ * A child's key comes from its parent's duals: excluding tj = (u, v) can only cost as much as
+ * raising the dual of v until another allowed edge into v gets reduced weight zero. If swapping
+ * that edge in for tj keeps an arborescence and costs exactly that much, the raised duals certify
+ * it, so the child is solved without a solve and shares its parent's contraction hierarchy.
+ * Otherwise the key is a lower bound, and the child is solved with chuLiuEdmondsTarjan on its
+ * allowed edges when it comes up.
+ *
+ * @param best Receives up to k arborescences, cheapest first; fewer if the graph has fewer.
+ * @return EdmondsStatus::Ok, NoArborescence or InvalidArgument.
+ */
+EdmondsStatus kBestArborescences(int n, int root, span<const Edge> edges, int k, vector<RankedArborescence>& best) {
+    best.clear();
+    struct Subproblem {
+        long long total;
+        vector<int> forced, excluded;
+        ArborescenceDuals duals;  // inEdge holds indices into edges
+    };
+    // edge indices by target
+    vector<int> inStart(max(n, 0) + 1, 0), inEdges(edges.size());
+    for (const Edge& edge : edges) {
+        if (edge.to >= 0 && edge.to < n) inStart[edge.to + 1]++;
+    }
+    partial_sum(inStart.begin(), inStart.end(), inStart.begin());
+    {
+        vector<int> fill(inStart.begin(), inStart.end() - 1);
+        for (size_t e = 0; e < edges.size(); e++) {
+            if (edges[e].to >= 0 && edges[e].to < n) inEdges[fill[edges[e].to]++] = (int)e;
+        }
+    }
+    EdgeConstraints constraints(n, edges.size());
+    auto allow = [&](const Subproblem& problem) {
+        constraints.clear();
+        for (int e : problem.excluded) constraints.forbid(e);
+        for (int e : problem.forced) constraints.force(edges, e);
+    };
+    // solves over the allowed edges; with a parent, edges whose reduced weight under the parent's
+    // duals exceeds budget cannot be in an arborescence within budget of the parent's weight and
+    // are left out, as long as the new duals still hold for them. The few edges left are copied,
+    // which is cheaper than a masked solve over all of them.
+    auto solve = [&](Subproblem& problem, const Subproblem* parent, long long budget) {
+        allow(problem);
+        for (;;) {
+            vector<Edge> kept;
+            vector<int> indices, pruned;
+            for (size_t e = 0; e < edges.size(); e++) {
+                const Edge& edge = edges[e];
+                if (!constraints.allowed(e, edge.to)) continue;
+                if (parent && edge.to != root && edge.from != edge.to &&
+                    edge.weight - parent->duals.enteredDual(edge.from, edge.to) > budget) {
+                    pruned.push_back((int)e);
+                    continue;
+                }
+                kept.push_back(edge);
+                indices.push_back((int)e);
+            }
+            int weight = 0;
+            EdmondsStatus status = chuLiuEdmondsTarjan(n, root, kept, weight, nullptr, nullptr, &problem.duals);
+            bool holds = status == EdmondsStatus::Ok;
+            for (size_t i = 0; i < pruned.size() && holds; i++) {
+                const Edge& edge = edges[pruned[i]];
+                holds = edge.weight >= problem.duals.enteredDual(edge.from, edge.to);
+            }
+            if (!holds && !pruned.empty()) {
+                parent = nullptr;
+                continue;
+            }
+            if (status != EdmondsStatus::Ok) return status;
+            for (int& e : problem.duals.inEdge) {
+                if (e >= 0) e = indices[e];
+            }
+            problem.total = weight;
+            return status;
+        }
+    };
+
+    auto first = make_shared<Subproblem>();
+    EdmondsStatus status = solve(*first, nullptr, 0);
+    if (status != EdmondsStatus::Ok || k <= 0) return status;
+
+    // a candidate is a child of a reported subproblem, described by position j among its free
+    // edges; swapEdge >= 0 marks a child already solved by swapping that edge in, and solved
+    // holds a child whose key is exact. Otherwise budget is what the best swap adds, if any.
+    struct Candidate {
+        long long key;
+        shared_ptr<const Subproblem> parent;
+        int position, swapEdge;
+        long long raise, budget;
+        shared_ptr<const Subproblem> solved;
+        bool operator>(const Candidate& other) const { return key > other.key; }
+    };
+    priority_queue<Candidate, vector<Candidate>, greater<Candidate>> queue;
+    queue.push({first->total, nullptr, 0, -1, 0, 0, first});
+    vector<int> freeEdges, pre(n), post(n), childStart(n + 1), children(n), stack;
+    while (!queue.empty() && (int)best.size() < k) {
+        Candidate candidate = queue.top();
+        queue.pop();
+        shared_ptr<const Subproblem> problem = candidate.solved;
+        if (!problem) {
+            const Subproblem& parent = *candidate.parent;
+            auto child = make_shared<Subproblem>();
+            child->forced = parent.forced;
+            child->excluded = parent.excluded;
+            int free = 0;
+            for (int v = 0; v < n && free <= candidate.position; v++) {
+                int e = parent.duals.inEdge[v];
+                if (v == root || find(parent.forced.begin(), parent.forced.end(), e) != parent.forced.end()) continue;
+                if (free++ < candidate.position) child->forced.push_back(e);
+                else child->excluded.push_back(e);
+            }
+            if (candidate.swapEdge >= 0) {
+                int v = edges[candidate.swapEdge].to;
+                child->duals = parent.duals;
+                child->duals.dual[v] += candidate.raise;
+                child->duals.inEdge[v] = candidate.swapEdge;
+                child->total = candidate.key;
+            } else {
+                if (solve(*child, candidate.budget < LLONG_MAX ? &parent : nullptr, candidate.budget) != EdmondsStatus::Ok) continue;
+                if (child->total > candidate.key) {
+                    queue.push({child->total, nullptr, 0, -1, 0, 0, child});
+                    continue;
+                }
+            }
+            problem = child;
+        }
+
+        RankedArborescence ranked{(int)problem->total, vector<int>(n, -1), problem->duals.inEdge};
+        for (int v = 0; v < n; v++) {
+            if (v != root) ranked.parent[v] = edges[ranked.inEdge[v]].from;
+        }
+        // pre/post order numbers of the arborescence, to tell which swaps would close a cycle
+        fill(childStart.begin(), childStart.end(), 0);
+        for (int v = 0; v < n; v++) {
+            if (v != root) childStart[ranked.parent[v] + 1]++;
+        }
+        partial_sum(childStart.begin(), childStart.end(), childStart.begin());
+        {
+            vector<int> fill(childStart.begin(), childStart.end() - 1);
+            for (int v = 0; v < n; v++) {
+                if (v != root) children[fill[ranked.parent[v]]++] = v;
+            }
+        }
+        int clock = 0;
+        stack.assign(1, root);
+        while (!stack.empty()) {
+            int v = stack.back();
+            stack.pop_back();
+            if (v < 0) {
+                post[~v] = clock++;
+                continue;
+            }
+            pre[v] = clock++;
+            stack.push_back(~v);
+            for (int c = childStart[v]; c < childStart[v + 1]; c++) stack.push_back(children[c]);
+        }
+
+        allow(*problem);
+        freeEdges.clear();
+        for (int v = 0; v < n; v++) {
+            int e = problem->duals.inEdge[v];
+            if (v != root && find(problem->forced.begin(), problem->forced.end(), e) == problem->forced.end()) {
+                freeEdges.push_back(e);
+            }
+        }
+        for (int j = 0; j < (int)freeEdges.size(); j++) {
+            int excluded = freeEdges[j], v = edges[excluded].to;
+            long long raise = LLONG_MAX, swapCost = LLONG_MAX;
+            int swapEdge = -1;
+            for (int i = inStart[v]; i < inStart[v + 1]; i++) {
+                int e = inEdges[i];
+                const Edge& edge = edges[e];
+                if (e == excluded || !constraints.allowed(e, v) || edge.from == v) continue;
+                raise = min(raise, edge.weight - problem->duals.enteredDual(edge.from, v));
+                bool descendant = pre[v] <= pre[edge.from] && post[edge.from] <= post[v];
+                long long cost = (long long)edge.weight - edges[excluded].weight;
+                if (!descendant && cost < swapCost) {
+                    swapCost = cost;
+                    swapEdge = e;
+                }
+            }
+            if (raise == LLONG_MAX) continue;
+            bool exact = swapEdge >= 0 && swapCost == raise;
+            queue.push({problem->total + raise, problem, j, exact ? swapEdge : -1, raise, swapCost, nullptr});
+        }
+        best.push_back(std::move(ranked));
+    }
+    return EdmondsStatus::Ok;
+}
+
+/**
+ * @brief A penalty for the edges leaving root larger than the difference in weight between any two
+ *        arborescences: Σ over the other nodes of their dearest minus their cheapest in-edge, plus
+ *        one. nullopt if a solve with it could overflow a long long.
+ */
+optional<long long> rootChildPenalty(int n, int root, span<const Edge> edges) {
+    vector<long long> cheapest(n, LLONG_MAX), dearest(n, LLONG_MIN);
+    long long largest = 0;
+    for (const Edge& edge : edges) {
+        if (edge.from == edge.to || edge.to == root) continue;
+        cheapest[edge.to] = min(cheapest[edge.to], (long long)edge.weight);
+        dearest[edge.to] = max(dearest[edge.to], (long long)edge.weight);
+        largest = max(largest, abs((long long)edge.weight));
+    }
+    long long penalty = 1;
+    for (int v = 0; v < n; v++) {
+        if (v != root && cheapest[v] != LLONG_MAX) penalty += dearest[v] - cheapest[v];
+    }
+    // reduced weights stay within n times the largest penalised weight
+    if (penalty > LLONG_MAX / 4 / (n + 1) - largest) return nullopt;
+    return penalty;
+}
+
+/**
+ * @brief The minimum spanning arborescence in which the root has exactly one child, as the root of
+ *        a dependency tree must.
+ *
+ * An unconstrained solve that already gives the root one child is the answer. Otherwise the
+ * edges leaving the root are penalised by rootChildPenalty, more than any two arborescences can
+ * differ in weight, and solved once more: the penalised optimum first has as few root children as
+ * possible, then the least weight.
+ * If the penalised weights could overflow, the children are tried one at a time instead, each
+ * forcing its cheapest root edge and forbidding the rest. That happens only when n times the
+ * penalty nears 2^61, i.e. with tens of thousands of nodes whose in-edge weights span most of the
+ * int range.
+ *
+ * @param parent If non-null, receives for each node its parent (-1 for the root).
+ * @return EdmondsStatus::Ok; NoArborescence if no such arborescence exists; InvalidArgument.
+ */
+EdmondsStatus chuLiuEdmondsSingleRootChild(int n, int root, span<const Edge> edges, int& minWeight,
+                                           vector<int>* parent = nullptr) {
+    vector<int> tree;
+    EdmondsStatus status = chuLiuEdmondsTarjan(n, root, edges, minWeight, &tree);
+    if (status != EdmondsStatus::Ok) return status;
+    int rootChildren = (int)count(tree.begin(), tree.end(), root);
+    if (rootChildren > 1) {
+        if (optional<long long> penalty = rootChildPenalty(n, root, edges)) {
+            status = chuLiuEdmondsTarjan(n, root, edges, minWeight, &tree, nullptr, nullptr, nullptr, *penalty);
+            if (status != EdmondsStatus::Ok) return status;
+            rootChildren = (int)count(tree.begin(), tree.end(), root);
+        } else {
+            vector<int> rootEdge(n, -1);
+            for (size_t e = 0; e < edges.size(); e++) {
+                int to = edges[e].to;
+                if (edges[e].from == root && to != root && (rootEdge[to] < 0 || edges[e].weight < edges[rootEdge[to]].weight)) {
+                    rootEdge[to] = (int)e;
+                }
+            }
+            EdgeConstraints constraints(n, edges.size());
+            bool found = false;
+            for (int child = 0; child < n; child++) {
+                if (rootEdge[child] < 0) continue;
+                constraints.clear();
+                for (size_t e = 0; e < edges.size(); e++) {
+                    if (edges[e].from == root && (int)e != rootEdge[child]) constraints.forbid(e);
+                }
+                constraints.force(edges, rootEdge[child]);
+                int weight = 0;
+                vector<int> candidate;
+                if (chuLiuEdmondsTarjan(n, root, edges, weight, &candidate, nullptr, nullptr, &constraints) ==
+                        EdmondsStatus::Ok && (!found || weight < minWeight)) {
+                    found = true;
+                    minWeight = weight;
+                    tree = std::move(candidate);
+                }
+            }
+            rootChildren = found ? 1 : 0;
+        }
+        if (rootChildren != 1) return EdmondsStatus::NoArborescence;
+    }
+    if (parent) *parent = std::move(tree);
+    return EdmondsStatus::Ok;
+}
+
+/**
+ * @brief Picks the root whose minimum spanning arborescence is cheapest, with a single solve.
+ *
+ * A virtual super-root n gets a zero-weight edge to every candidate. Penalising those edges by
+ * rootChildPenalty makes the optimum leave the super-root through exactly one of them whenever it
+ * can: that candidate is the best root, and the rest is its minimum spanning arborescence. The
+ * penalty is only ever added inside the long long heaps, never to the int edge weights; if even
+ * those could overflow (see chuLiuEdmondsSingleRootChild for when), the candidates are solved one
+ * at a time instead.
+ *
+ * @param root Receives the chosen root.
+ * @param parent If non-null, receives for each node its parent (-1 for the chosen root).
+ * @param candidates The nodes that may be the root; every node if empty.
+ * @return EdmondsStatus::Ok; NoArborescence if no candidate reaches every node; InvalidArgument.
+ */
+EdmondsStatus chuLiuEdmondsBestRoot(int n, span<const Edge> edges, int& root, int& minWeight,
+                                    vector<int>* parent = nullptr, span<const int> candidates = {}) {
+    if (n <= 0) return EdmondsStatus::InvalidArgument;
+    vector<int> all;
+    if (candidates.empty()) {
+        all.resize(n);
+        iota(all.begin(), all.end(), 0);
+        candidates = all;
+    }
+    for (int candidate : candidates) {
+        if (candidate < 0 || candidate >= n) return EdmondsStatus::InvalidArgument;
+    }
+    // checked before the super-root joins, which would make node n look valid
+    for (const Edge& edge : edges) {
+        if (edge.from < 0 || edge.from >= n || edge.to < 0 || edge.to >= n) return EdmondsStatus::InvalidArgument;
+    }
+    vector<Edge> augmented(edges.begin(), edges.end());
+    for (int candidate : candidates) augmented.push_back({n, candidate, 0});
+    vector<int> tree;
+    if (optional<long long> penalty = rootChildPenalty(n + 1, n, augmented)) {
+        EdmondsStatus status =
+            chuLiuEdmondsTarjan(n + 1, n, augmented, minWeight, &tree, nullptr, nullptr, nullptr, *penalty);
+        if (status != EdmondsStatus::Ok) return status;
+        if (count(tree.begin(), tree.end(), n) != 1) return EdmondsStatus::NoArborescence;
+        root = (int)(find(tree.begin(), tree.end(), n) - tree.begin());
+        tree.resize(n);
+        tree[root] = -1;
+    } else {
+        bool found = false;
+        for (int candidate : candidates) {
+            int weight = 0;
+            vector<int> candidateTree;
+            if (chuLiuEdmondsTarjan(n, candidate, edges, weight, &candidateTree) == EdmondsStatus::Ok &&
+                (!found || weight < minWeight)) {
+                found = true;
+                root = candidate;
+                minWeight = weight;
+                tree = std::move(candidateTree);
+            }
+        }
+        if (!found) return EdmondsStatus::NoArborescence;
+    }
+    if (parent) *parent = std::move(tree);
+    return EdmondsStatus::Ok;
+}
+
+/**
+ * @brief Finds a minimum spanning branching: a forest of least weight in which every node has at
+ *        most one parent. No root is needed, and an edge is only used if it pays for itself.
+ *
+ * The branching is the minimum spanning arborescence of the graph plus a virtual root n with a
+ * zero-weight edge to every node, which a node keeps when none of its in-edges lowers the total;
+ * solved with chuLiuEdmondsTarjan in O(E log V).
+ *
+ * @param parent If non-null, receives for each node its parent, or -1 for the roots of the forest.
+ * @return EdmondsStatus::Ok, or InvalidArgument.
+ */
+EdmondsStatus minimumBranching(int n, span<const Edge> edges, int& minWeight, vector<int>* parent = nullptr) {
+    if (n <= 0) return EdmondsStatus::InvalidArgument;
+    // checked before the virtual root joins, which would make node n look valid
+    for (const Edge& edge : edges) {
+        if (edge.from < 0 || edge.from >= n || edge.to < 0 || edge.to >= n) return EdmondsStatus::InvalidArgument;
+    }
+    vector<Edge> augmented(edges.begin(), edges.end());
+    for (int v = 0; v < n; v++) augmented.push_back({n, v, 0});
+    vector<int> tree;
+    EdmondsStatus status = chuLiuEdmondsTarjan(n + 1, n, augmented, minWeight, parent ? &tree : nullptr);
+    if (status != EdmondsStatus::Ok || !parent) return status;
+    tree.resize(n);
+    for (int& from : tree) {
+        if (from == n) from = -1;
+    }
+    *parent = std::move(tree);
+    return status;
+}
+
+/**
+ * @brief Solves over the part of the graph the root reaches instead of failing when some node is
+ *        unreachable.
+ *
+ * One breadth-first pass over the edges bucketed by source finds the reachable nodes. They are
+ * renumbered in the order they were reached, and chuLiuEdmondsTarjan solves the subgraph they
+ * induce. When every node is reachable, the edges are solved in place without a copy.
+ *
+ * @param excluded Receives the unreachable nodes in increasing order.
+ * @param parent If non-null, receives for each node its parent, or -1 for the root and the
+ *               excluded nodes.
+ * @return EdmondsStatus::Ok and the weight of the minimum arborescence spanning the reachable
+ *         nodes, or InvalidArgument.
+ */
+EdmondsStatus chuLiuEdmondsReachable(int n, int root, span<const Edge> edges, int& minWeight, vector<int>& excluded,
+                                     vector<int>* parent = nullptr) {
+    excluded.clear();
+    if (n <= 0 || root < 0 || root >= n) return EdmondsStatus::InvalidArgument;
+    vector<int> outStart(n + 1, 0);
+    for (const Edge& edge : edges) {
+        if (edge.from < 0 || edge.from >= n || edge.to < 0 || edge.to >= n) return EdmondsStatus::InvalidArgument;
+        outStart[edge.from + 1]++;
+    }
+    partial_sum(outStart.begin(), outStart.end(), outStart.begin());
+    vector<int> targets(edges.size());
+    {
+        vector<int> fill(outStart.begin(), outStart.end() - 1);
+        for (const Edge& edge : edges) targets[fill[edge.from]++] = edge.to;
+    }
+    // id is a node's number in the reachable subgraph, and order lists the nodes by that number
+    vector<int> id(n, -1), order;
+    order.reserve(n);
+    id[root] = 0;
+    order.push_back(root);
+    for (size_t head = 0; head < order.size(); head++) {
+        int u = order[head];
+        for (int i = outStart[u]; i < outStart[u + 1]; i++) {
+            if (id[targets[i]] < 0) {
+                id[targets[i]] = (int)order.size();
+                order.push_back(targets[i]);
+            }
+        }
+    }
+    if ((int)order.size() == n) return chuLiuEdmondsTarjan(n, root, edges, minWeight, parent);
+
+    for (int v = 0; v < n; v++) {
+        if (id[v] < 0) excluded.push_back(v);
+    }
+    vector<Edge> reachable;
+    for (const Edge& edge : edges) {
+        if (id[edge.from] >= 0 && id[edge.to] >= 0) reachable.push_back({id[edge.from], id[edge.to], edge.weight});
+    }
+    vector<int> tree;
+    EdmondsStatus status =
+        chuLiuEdmondsTarjan((int)order.size(), 0, reachable, minWeight, parent ? &tree : nullptr);
+    if (status != EdmondsStatus::Ok || !parent) return status;
+    parent->assign(n, -1);
+    for (size_t v = 1; v < order.size(); v++) (*parent)[order[v]] = order[tree[v]];
+    return status;
+}
+
+static_assert(sizeof(edmonds_edge) == sizeof(Edge) && alignof(edmonds_edge) == alignof(Edge),
+              "edmonds_edge must stay layout-compatible with Edge");
+
+/**
+ * @brief Maps a solver status onto the EDMONDS_* codes of the C ABI.
+ */
+int cAbiStatus(EdmondsStatus status) {
+    switch (status) {
+        case EdmondsStatus::Ok: return EDMONDS_OK;
+        case EdmondsStatus::NoArborescence: return EDMONDS_NO_ARBORESCENCE;
+        case EdmondsStatus::WorkspaceTooSmall: return EDMONDS_WORKSPACE_TOO_SMALL;
+        case EdmondsStatus::OutOfMemory: return EDMONDS_OUT_OF_MEMORY;
+        default: return EDMONDS_INVALID_ARGUMENT;
+    }
+}
+
+/**
+ * @brief Solves through chuLiuEdmondsOver for the C ABI: carves the flat workspace block into
+ * spans (allocating one if the caller passed none) and maps the result onto EDMONDS_* codes.
+ *
+ * The round solver keeps no parents, so a call that asks for them is solved by chuLiuEdmondsTarjan
+ * instead, in memory of its own; parallel arrays are packed into Edges for it first.
+ */
+template <class EdgeView>
+int solveForCAbi(int32_t n, int32_t root, const EdgeView& edges, void* workspace, size_t workspaceBytes,
+                 int32_t* total, int32_t* parent) {
+    if (!total || n <= 0) return EDMONDS_INVALID_ARGUMENT;
+    try {
+        int minWeight = 0;
+        if (parent) {
+            vector<Edge> packed;
+            span<const Edge> view;
+            if constexpr (is_same_v<EdgeView, span<const Edge>>) {
+                view = edges;
+            } else {
+                packed.resize(edges.size());
+                for (size_t e = 0; e < edges.size(); e++) packed[e] = edges[e];
+                view = packed;
+            }
+            vector<int> tree;
+            EdmondsStatus status = chuLiuEdmondsTarjan(n, root, view, minWeight, &tree);
+            if (status == EdmondsStatus::Ok) {
+                *total = minWeight;
+                copy(tree.begin(), tree.end(), parent);
+            }
+            return cAbiStatus(status);
+        }
+
+        size_t needed = edmonds_workspace_bytes(n, edges.size());
+        unique_ptr<byte[]> owned;
+        if (!workspace) {
+            owned.reset(new byte[needed]);
+            workspace = owned.get();
+            workspaceBytes = needed;
+        }
+        if ((uintptr_t)workspace % alignof(Edge) != 0) return EDMONDS_INVALID_ARGUMENT;
+        if (workspaceBytes < needed) return EDMONDS_WORKSPACE_TOO_SMALL;
+
+        EdmondsWorkspaceSize size = requiredWorkspace(n, edges.size());
+        int* nodeInts = static_cast<int*>(workspace);
+        EdmondsWorkspace spans = {
+            {nodeInts, size.nodeInts},
+            {nodeInts + size.nodeInts, size.nodeInts},
+            {nodeInts + 2 * size.nodeInts, size.nodeInts},
+            {nodeInts + 3 * size.nodeInts, size.nodeInts},
+            {nodeInts + 4 * size.nodeInts, size.nodeInts},
+            {reinterpret_cast<Edge*>(nodeInts + EdmondsWorkspace::NODE_ARRAYS * size.nodeInts), size.scratchEdges}};
+        EdmondsStatus status = chuLiuEdmondsOver(n, root, edges, spans, minWeight);
+        if (status == EdmondsStatus::Ok) *total = minWeight;
+        return cAbiStatus(status);
+    } catch (const bad_alloc&) {
+        return EDMONDS_OUT_OF_MEMORY;
+    }
+}
+
+extern "C" {
+
+EDMONDS_API uint32_t edmonds_abi_version(void) {
+    return EDMONDS_ABI_VERSION;
+}
+
+EDMONDS_API size_t edmonds_workspace_bytes(int32_t n, size_t num_edges) {
+    EdmondsWorkspaceSize size = requiredWorkspace(n, num_edges);
+    return EdmondsWorkspace::NODE_ARRAYS * size.nodeInts * sizeof(int) + size.scratchEdges * sizeof(Edge);
+}
+
+EDMONDS_API int edmonds_solve_edges(int32_t n, int32_t root, const edmonds_edge* edges, size_t num_edges,
+                                    void* workspace, size_t workspace_bytes, int32_t* total, int32_t* parent) {
+    if (!edges && num_edges > 0) return EDMONDS_INVALID_ARGUMENT;
+    span<const Edge> view(reinterpret_cast<const Edge*>(edges), num_edges);
+    return solveForCAbi(n, root, view, workspace, workspace_bytes, total, parent);
+}
+
+EDMONDS_API int edmonds_solve_arrays(int32_t n, int32_t root, const int32_t* from, const int32_t* to,
+                                     const int32_t* weight, size_t num_edges,
+                                     void* workspace, size_t workspace_bytes, int32_t* total, int32_t* parent) {
+    if ((!from || !to || !weight) && num_edges > 0) return EDMONDS_INVALID_ARGUMENT;
+    return solveForCAbi(n, root, EdgeArraysView{from, to, weight, num_edges}, workspace, workspace_bytes, total,
+                        parent);
+}
+
+}
+
+/**
+ * @brief Read-only memory mapping of a whole file. Move-only; unmaps on destruction.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            mapping = exchange(other.mapping, nullptr);
+            length = exchange(other.length, 0);
+        }
+        return *this;
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    /**
+     * @brief Maps the file at path. Returns false (with errno set) if it cannot be opened or mapped.
+     */
+    bool open(const string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        bool mapped = open(fd);
+        ::close(fd);
+        return mapped;
+    }
+
+    /**
+     * @brief Maps the whole of an open file, such as a memfd. The descriptor stays owned by the
+     * caller and may be closed once this returns.
+     */
+    bool open(int fd) {
+        close();
+        struct stat info;
+        if (fstat(fd, &info) != 0) return false;
+        length = (size_t)info.st_size;
+        if (length > 0) {
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                length = 0;
+                return false;
+            }
+            mapping = static_cast<const byte*>(p);
+        }
+        return true;
+    }
+
+    void close() {
+        if (mapping) munmap(const_cast<byte*>(mapping), length);
+        mapping = nullptr;
+        length = 0;
+    }
+
+    const byte* data() const { return mapping; }
+    size_t size() const { return length; }
+
+private:
+    const byte* mapping = nullptr;
+    size_t length = 0;
+};
+
+const char GRAPH_FILE_MAGIC[4] = {'E', 'D', 'M', 'G'};
+const uint32_t GRAPH_FILE_VERSION = 1;
+const uint32_t GRAPH_WEIGHT_INT32 = 1;
+const uint32_t GRAPH_BUCKETED_BY_DESTINATION = 1;
+
+/**
+ * @brief Header of the binary graph file format.
+ *
+ * A graph file is this header, then n + 1 uint64 bucket offsets, then numEdges Edge records, all
+ * in native byte order. Edges are sorted by destination, and the edges entering node v are
+ * edges[offsets[v], offsets[v + 1]).
+ */
+struct GraphFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t weightType;
+    uint32_t flags;
+    int32_t n, root;
+    uint64_t numEdges;
+};
+
+static_assert(sizeof(GraphFileHeader) == 32, "GraphFileHeader is part of the on-disk format");
+
+/**
+ * @brief Writes a graph in the binary graph file format, bucketing its edges by destination.
+ *
+ * @return true on success, false (with errno set) if the file could not be written, or with
+ *         errno EINVAL if n, root or an edge endpoint is out of range.
+ */
+bool writeGraphFile(const string& path, int n, int root, span<const Edge> edges) {
+    bool valid = n > 0 && root >= 0 && root < n;
+    for (size_t e = 0; e < edges.size() && valid; e++) {
+        valid = edges[e].from >= 0 && edges[e].from < n && edges[e].to >= 0 && edges[e].to < n;
+    }
+    if (!valid) {
+        errno = EINVAL;
+        return false;
+    }
+    vector<uint64_t> offsets(n + 1, 0);
+    for (const Edge& edge : edges) {
+        offsets[edge.to + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+    vector<Edge> bucketed(edges.size());
+    vector<uint64_t> next(offsets.begin(), offsets.end() - 1);
+    for (const Edge& edge : edges) {
+        bucketed[next[edge.to]++] = edge;
+    }
+
+    GraphFileHeader header = {};
+    memcpy(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic));
+    header.version = GRAPH_FILE_VERSION;
+    header.weightType = GRAPH_WEIGHT_INT32;
+    header.flags = GRAPH_BUCKETED_BY_DESTINATION;
+    header.n = n;
+    header.root = root;
+    header.numEdges = edges.size();
+
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(bucketed.data()), bucketed.size() * sizeof(Edge));
+    out.close();
+    return !out.fail();
+}
+
+/**
+ * @brief Checks a graph file header against the size of its file.
+ *
+ * @return The byte offset of the edge records, or 0 if the header does not describe a
+ *         well-formed graph file of fileSize bytes.
+ */
+size_t graphFileEdgeOffset(const GraphFileHeader& header, size_t fileSize) {
+    if (memcmp(header.magic, GRAPH_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != GRAPH_FILE_VERSION || header.weightType != GRAPH_WEIGHT_INT32 ||
+        header.n <= 0 || header.root < 0 || header.root >= header.n) {
+        return 0;
+    }
+    size_t edgeOffset = sizeof(GraphFileHeader) + ((size_t)header.n + 1) * sizeof(uint64_t);
+    if (fileSize < edgeOffset || (fileSize - edgeOffset) % sizeof(Edge) != 0 ||
+        header.numEdges != (fileSize - edgeOffset) / sizeof(Edge)) {
+        return 0;
+    }
+    return edgeOffset;
+}
+
+/**
+ * @brief Checks a graph file's n + 1 bucket offsets: they must start at 0, never decrease, and
+ * end at numEdges, so that every bucket lies inside the edge records.
+ */
+bool graphFileOffsetsValid(span<const uint64_t> offsets, uint64_t numEdges) {
+    if (offsets.empty() || offsets.front() != 0 || offsets.back() != numEdges) return false;
+    for (size_t v = 1; v < offsets.size(); v++) {
+        if (offsets[v] < offsets[v - 1]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief A graph file mapped into memory. edges() points straight into the mapping, so the
+ * solver reads the file's pages directly and nothing is parsed or copied at load time.
+ */
+class MappedGraph {
+public:
+    /**
+     * @brief Maps and validates the graph file at path.
+     *
+     * @return false if the file cannot be mapped or is not a well-formed graph file.
+     */
+    bool open(const string& path) {
+        if (!file.open(path) || file.size() < sizeof(GraphFileHeader)) return fail();
+        const GraphFileHeader* header = reinterpret_cast<const GraphFileHeader*>(file.data());
+        size_t edgeOffset = graphFileEdgeOffset(*header, file.size());
+        if (edgeOffset == 0) return fail();
+        n = header->n;
+        rootNode = header->root;
+        bucketOffsets = {reinterpret_cast<const uint64_t*>(file.data() + sizeof(GraphFileHeader)), (size_t)n + 1};
+        edgeView = {reinterpret_cast<const Edge*>(file.data() + edgeOffset), (size_t)header->numEdges};
+        if (!graphFileOffsetsValid(bucketOffsets, header->numEdges)) return fail();
+        madvise(const_cast<byte*>(file.data()), file.size(), MADV_SEQUENTIAL);
+        return true;
+    }
+
+    int nodes() const { return n; }
+    int root() const { return rootNode; }
+    span<const Edge> edges() const { return edgeView; }
+
+    /**
+     * @brief The edges entering node v.
+     */
+    span<const Edge> edgesInto(int v) const {
+        return edgeView.subspan(bucketOffsets[v], bucketOffsets[v + 1] - bucketOffsets[v]);
+    }
+
+private:
+    bool fail() {
+        file.close();
+        n = rootNode = 0;
+        bucketOffsets = {};
+        edgeView = {};
+        return false;
+    }
+
+    MappedFile file;
+    int n = 0, rootNode = 0;
+    span<const uint64_t> bucketOffsets;
+    span<const Edge> edgeView;
+};
+
+/**
+ * @brief Reads a text edge list of "from to weight" lines. Node ids must be dense and non-negative.
+ *
+ * @return The number of nodes (largest id + 1), or -1 on a malformed line.
+ */
+int readTextEdgeList(istream& in, vector<Edge>& edges) {
+    int n = 0;
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream fields(line);
+        Edge edge;
+        if (!(fields >> edge.from >> edge.to >> edge.weight) || edge.from < 0 || edge.to < 0) return -1;
+        edges.push_back(edge);
+        n = max(n, max(edge.from, edge.to) + 1);
+    }
+    return n;
+}
+
+/**
+ * @brief Converts a text edge list (see readTextEdgeList) into a binary graph file rooted at root.
+ */
+bool convertTextEdgeList(istream& in, int root, const string& path) {
+    vector<Edge> edges;
+    int n = readTextEdgeList(in, edges);
+    if (n < 0 || root < 0) return false;
+    return writeGraphFile(path, max(n, root + 1), root, edges);
+}
+
+/**
+ * @brief Maps arbitrary 64-bit node ids (e.g. hashes) to the dense ids in [0, n) the solver indexes by.
+ *
+ * Keys are split into 64 shards by the top bits of a mixed hash; each shard is a linear-probing
+ * table of (key, id) slots kept at most half full, so a lookup is usually one cache line. During
+ * a parallel build, threads first partition their slice of the input by shard and then each
+ * shard is filled by one thread in input order. Dense ids are therefore grouped by shard and, within a
+ * shard, follow first appearance; they do not depend on the number of threads.
+ */
+class NodeIdMap {
+public:
+    /**
+     * @brief Builds the map from the endpoints of an edge list given as two id columns, visiting
+     * from[0], to[0], from[1], to[1], ... Replaces any previous contents.
+     *
+     * @param threads Number of build threads; 0 uses the hardware concurrency.
+     * @return false, leaving the map empty, if there are INT_MAX or more distinct ids, more than
+     *         dense int ids can number.
+     */
+    bool build(span<const uint64_t> from, span<const uint64_t> to, int threads = 0) {
+        return buildFrom(from.size() + to.size(), [&](size_t i) { return i % 2 ? to[i / 2] : from[i / 2]; }, threads);
+    }
+
+    /**
+     * @brief Builds the map from a single list of ids. Replaces any previous contents.
+     *
+     * @return false, leaving the map empty, if there are INT_MAX or more distinct ids.
+     */
+    bool build(span<const uint64_t> ids, int threads = 0) {
+        return buildFrom(ids.size(), [&](size_t i) { return ids[i]; }, threads);
+    }
+
+    /**
+     * @brief Number of distinct ids, i.e. the n to solve with.
+     */
+    int size() const { return (int)originals.size(); }
+
+    /**
+     * @brief The dense id of an original id, or -1 if the id was not in the input.
+     */
+    int find(uint64_t id) const {
+        uint64_t h = mix(id);
+        const Shard& shard = shards[h >> (64 - SHARD_BITS)];
+        if (shard.slots.empty()) return -1;
+        size_t mask = shard.slots.size() - 1;
+        for (size_t i = h & mask; ; i = (i + 1) & mask) {
+            const Slot& slot = shard.slots[i];
+            if (slot.id < 0) return -1;
+            if (slot.key == id) return shard.base + slot.id;
+        }
+    }
+
+    /**
+     * @brief The original id of dense node v.
+     */
+    uint64_t originalId(int v) const { return originals[v]; }
+
+    /**
+     * @brief Builds the map over an edge list in original ids and returns the same edges over dense ids,
+     * or an empty list if the build fails (see build).
+     */
+    vector<Edge> remapEdges(span<const uint64_t> from, span<const uint64_t> to, span<const int32_t> weight,
+                            int threads = 0) {
+        if (!build(from, to, threads)) return {};
+        vector<Edge> edges(from.size());
+        parallelFor(from.size(), resolveThreads(threads), [&](size_t begin, size_t end) {
+            for (size_t e = begin; e < end; e++) {
+                edges[e] = {find(from[e]), find(to[e]), weight[e]};
+            }
+        });
+        return edges;
+    }
+
+    /**
+     * @brief Translates a dense parent array (parent[v] = -1 for the root) into the arborescence's
+     * (child, parent) pairs in original ids.
+     */
+    vector<pair<uint64_t, uint64_t>> originalArborescence(span<const int> parent) const {
+        vector<pair<uint64_t, uint64_t>> tree;
+        tree.reserve(parent.size());
+        for (size_t v = 0; v < parent.size(); v++) {
+            if (parent[v] >= 0) tree.push_back({originals[v], originals[parent[v]]});
+        }
+        return tree;
+    }
+
+private:
+    static const int SHARD_BITS = 6;
+    static const int SHARDS = 1 << SHARD_BITS;
+
+    struct Slot {
+        uint64_t key;
+        int id;   // shard-local id, -1 for an empty slot
+    };
+
+    struct Shard {
+        vector<Slot> slots;
+        int base = 0;   // dense id of the shard's first key
+    };
+
+    static uint64_t mix(uint64_t x) {
+        // splitmix64 finalizer: spreads clustered or sequential ids over the shards and slots
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    static int resolveThreads(int threads) {
+        return threads > 0 ? threads : (int)max(1u, thread::hardware_concurrency());
+    }
+
+    template <class Work>
+    static void parallelFor(size_t count, int threads, Work work) {
+        vector<thread> workers;
+        for (int t = 1; t < threads; t++) {
+            workers.emplace_back(work, count * t / threads, count * (t + 1) / threads);
+        }
+        work(0, count / threads);
+        for (thread& worker : workers) worker.join();
+    }
+
+    template <class KeyAt>
+    bool buildFrom(size_t count, KeyAt keyAt, int threads) {
+        threads = resolveThreads(threads);
+        if (count < 4096) threads = 1;
+
+        // Partition each thread's slice of the input by shard, keeping input order
+        vector<array<vector<uint64_t>, SHARDS>> partitions(threads);
+        vector<thread> workers;
+        auto partition = [&](int t) {
+            for (size_t i = count * t / threads; i < count * (t + 1) / threads; i++) {
+                uint64_t key = keyAt(i);
+                partitions[t][mix(key) >> (64 - SHARD_BITS)].push_back(key);
+            }
+        };
+        for (int t = 1; t < threads; t++) workers.emplace_back(partition, t);
+        partition(0);
+        for (thread& worker : workers) worker.join();
+        workers.clear();
+
+        // Fill each shard from the partitions in thread order, assigning ids by first appearance
+        array<vector<uint64_t>, SHARDS> shardOriginals;
+        auto fill = [&](int t) {
+            for (int s = t; s < SHARDS; s += threads) {
+                size_t keys = 0;
+                for (int p = 0; p < threads; p++) keys += partitions[p][s].size();
+                size_t capacity = 1;
+                while (capacity < 2 * keys) capacity <<= 1;
+                Shard& shard = shards[s];
+                shard.slots.assign(keys ? capacity : 0, Slot{0, -1});
+                size_t mask = capacity - 1;
+                for (int p = 0; p < threads; p++) {
+                    for (uint64_t key : partitions[p][s]) {
+                        size_t i = mix(key) & mask;
+                        while (shard.slots[i].id >= 0 && shard.slots[i].key != key) i = (i + 1) & mask;
+                        if (shard.slots[i].id < 0) {
+                            shard.slots[i] = {key, (int)shardOriginals[s].size()};
+                            shardOriginals[s].push_back(key);
+                        }
+                    }
+                    vector<uint64_t>().swap(partitions[p][s]);
+                }
+            }
+        };
+        for (int t = 1; t < threads; t++) workers.emplace_back(fill, t);
+        fill(0);
+        for (thread& worker : workers) worker.join();
+
+        originals.clear();
+        size_t total = 0;
+        for (int s = 0; s < SHARDS; s++) total += shardOriginals[s].size();
+        if (total >= (size_t)INT_MAX) {
+            for (Shard& shard : shards) shard = {};
+            return false;
+        }
+        for (int s = 0; s < SHARDS; s++) {
+            shards[s].base = (int)originals.size();
+            originals.insert(originals.end(), shardOriginals[s].begin(), shardOriginals[s].end());
+        }
+        return true;
+    }
+
+    array<Shard, SHARDS> shards;
+    vector<uint64_t> originals;
+};
+
+/**
+ * @brief Text edge-list dialects understood by parseEdgeList.
+ *
+ * Triples: "from to weight" lines; '#' and '%' start comment lines.
+ * Snap: SNAP edge lists, "from<TAB>to" with an optional weight (default 1); '#' starts comments.
+ * Dimacs: "a from to weight" arc lines with 1-based ids, an optional "p sp n m" problem line, and
+ * 'c' comment lines.
+ */
+enum class EdgeListFormat {
+    Triples,
+    Snap,
+    Dimacs
+};
+
+/**
+ * @brief Result of parseEdgeList.
+ */
+struct ParsedEdgeList {
+    int n = 0;                     // number of nodes
+    vector<Edge> edges;            // edges over dense ids in [0, n)
+    NodeIdMap ids;                 // maps the ids in the file to dense ids, if they were remapped
+};
+
+/**
+ * @brief A parsed edge before its ids are made dense.
+ */
+struct RawEdge {
+    int64_t from, to;
+    int weight;
+};
+
+/**
+ * @brief Whether the line [p, end) holds an edge in the given format. Used to size the output
+ * before parsing; lines it accepts but parseEdgeLine rejects make the parse fail.
+ */
+bool lineHoldsEdge(const char* p, const char* end, EdgeListFormat format) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    if (p == end) return false;
+    if (format == EdgeListFormat::Dimacs) return *p == 'a';
+    return *p != '#' && *p != '%';
+}
+
+/**
+ * @brief Parses the edge on line [p, end). Returns false if the line is malformed.
+ */
+bool parseEdgeLine(const char* p, const char* end, EdgeListFormat format, RawEdge& edge) {
+    auto skipBlanks = [&] {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+    };
+    auto readInt = [&](auto& value) {
+        skipBlanks();
+        auto [next, error] = from_chars(p, end, value);
+        if (error != errc() || (next < end && *next != ' ' && *next != '\t' && *next != '\r')) return false;
+        p = next;
+        return true;
+    };
+    skipBlanks();
+    if (format == EdgeListFormat::Dimacs) p++;
+    if (!readInt(edge.from) || !readInt(edge.to)) return false;
+    skipBlanks();
+    if (format == EdgeListFormat::Snap && p == end) {
+        edge.weight = 1;
+    } else if (!readInt(edge.weight)) {
+        return false;
+    }
+    skipBlanks();
+    if (p != end) return false;
+    if (format == EdgeListFormat::Dimacs) {
+        edge.from--;
+        edge.to--;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a text edge list in parallel.
+ *
+ * The text is split into one chunk per thread at line boundaries. A first parallel pass counts
+ * the edge lines of each chunk, so the second pass can parse every chunk with std::from_chars
+ * straight into its slice of the output edge vector.
+ *
+ * @param text The whole file contents, e.g. from a MappedFile.
+ * @param format The dialect of the file.
+ * @param out Receives the graph. With remapIds, arbitrary (sparse, negative, 64-bit) ids are mapped
+ *            to dense ids through out.ids, which also translates results back; otherwise ids must
+ *            already lie in [0, INT_MAX).
+ * @param threads Number of parsing threads; 0 uses the hardware concurrency.
+ * @return true on success, false if some line is malformed, an id is out of range, or remapping
+ *         finds INT_MAX or more distinct ids.
+ */
+bool parseEdgeList(string_view text, EdgeListFormat format, ParsedEdgeList& out, bool remapIds = false,
+                   int threads = 0) {
+    if (threads <= 0) {
+        threads = (int)max(1u, thread::hardware_concurrency());
+        threads = (int)min<size_t>(threads, max<size_t>(1, text.size() / (64 * 1024)));
+    }
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+
+    // Chunk c covers [bounds[c], bounds[c + 1]), each ending just after a newline
+    vector<const char*> bounds(threads + 1, end);
+    bounds[0] = begin;
+    for (int c = 1; c < threads; c++) {
+        const char* p = begin + text.size() * c / threads;
+        p = max(p, bounds[c - 1]);
+        const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+        bounds[c] = newline ? newline + 1 : end;
+    }
+
+    auto forEachLine = [](const char* p, const char* chunkEnd, auto&& visit) {
+        while (p < chunkEnd) {
+            const char* newline = static_cast<const char*>(memchr(p, '\n', chunkEnd - p));
+            const char* lineEnd = newline ? newline : chunkEnd;
+            if (!visit(p, lineEnd)) return false;
+            p = lineEnd + 1;
+        }
+        return true;
+    };
+    auto runChunks = [&](auto&& work) {
+        vector<thread> workers;
+        for (int c = 1; c < threads; c++) workers.emplace_back(work, c);
+        work(0);
+        for (thread& worker : workers) worker.join();
+    };
+
+    vector<size_t> firstEdge(threads + 1, 0);
+    vector<int64_t> declaredNodes(threads, 0);
+    runChunks([&](int c) {
+        size_t count = 0;
+        forEachLine(bounds[c], bounds[c + 1], [&](const char* p, const char* lineEnd) {
+            if (format == EdgeListFormat::Dimacs && *p == 'p') {
+                // "p sp <nodes> <arcs>": skip the two words, then read the node count
+                const char* q = p;
+                for (int word = 0; word < 2; word++) {
+                    while (q < lineEnd && *q != ' ' && *q != '\t') q++;
+                    while (q < lineEnd && (*q == ' ' || *q == '\t')) q++;
+                }
+                from_chars(q, lineEnd, declaredNodes[c]);
+            }
+            count += lineHoldsEdge(p, lineEnd, format);
+            return true;
+        });
+        firstEdge[c + 1] = count;
+    });
+    for (int c = 0; c < threads; c++) firstEdge[c + 1] += firstEdge[c];
+
+    size_t numEdges = firstEdge[threads];
+    vector<uint64_t> rawFrom(remapIds ? numEdges : 0), rawTo(remapIds ? numEdges : 0);
+    vector<int32_t> rawWeight(remapIds ? numEdges : 0);
+    out.edges.resize(remapIds ? 0 : numEdges);
+    vector<char> ok(threads, 1);
+    vector<int64_t> maxId(threads, -1);
+    runChunks([&](int c) {
+        size_t next = firstEdge[c];
+        ok[c] = forEachLine(bounds[c], bounds[c + 1], [&](const char* p, const char* lineEnd) {
+            if (!lineHoldsEdge(p, lineEnd, format)) return true;
+            RawEdge edge;
+            if (!parseEdgeLine(p, lineEnd, format, edge)) return false;
+            if (remapIds) {
+                rawFrom[next] = (uint64_t)edge.from;
+                rawTo[next] = (uint64_t)edge.to;
+                rawWeight[next++] = edge.weight;
+                return true;
+            }
+            if (edge.from < 0 || edge.to < 0 || edge.from >= INT_MAX || edge.to >= INT_MAX) return false;
+            out.edges[next++] = {(int)edge.from, (int)edge.to, edge.weight};
+            maxId[c] = max(maxId[c], max(edge.from, edge.to));
+            return true;
+        });
+    });
+    if (count(ok.begin(), ok.end(), 0) > 0) return false;
+
+    if (!remapIds) {
+        int64_t n = max(*max_element(maxId.begin(), maxId.end()) + 1,
+                        *max_element(declaredNodes.begin(), declaredNodes.end()));
+        if (n >= INT_MAX) return false;
+        out.n = (int)n;
+        return true;
+    }
+
+    out.edges = out.ids.remapEdges(rawFrom, rawTo, rawWeight, threads);
+    if (out.edges.size() != numEdges) return false;   // INT_MAX or more distinct ids
+    out.n = out.ids.size();
+    return true;
+}
+
+/**
+ * @brief Maps the file at path and parses it with parseEdgeList.
+ */
+bool loadEdgeList(const string& path, EdgeListFormat format, ParsedEdgeList& out, bool remapIds = false,
+                  int threads = 0) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+    string_view text(reinterpret_cast<const char*>(file.data()), file.size());
+    return parseEdgeList(text, format, out, remapIds, threads);
+}
+
+/**
+ * @brief An edge list compressed by destination, at roughly 3 bytes per edge for typical graphs
+ * instead of the 12 of an Edge.
+ *
+ * The edges entering each node form one group: a varint header (edge count, first source,
+ * source and weight of the group's minimum edge, bit widths) followed by the gaps between the
+ * sorted sources and the weights' offsets from the group minimum, each bit-packed at a fixed
+ * width. Self-loops are dropped, since they never take part in an arborescence. Storing the
+ * group minimum in the header makes min-incoming-edge selection O(V) without decoding any edge;
+ * full passes decode each group with fixed-width extractions from 64-bit loads.
+ */
+class CompressedGraph {
+public:
+    CompressedGraph() = default;
+
+    /**
+     * @brief Compresses a graph with n nodes and the given edges.
+     *
+     * If n is not positive or an edge endpoint lies outside [0, n), nothing is built and valid()
+     * is false.
+     */
+    CompressedGraph(int n, span<const Edge> edges) {
+        if (n <= 0) return;
+        for (const Edge& edge : edges) {
+            if (edge.from < 0 || edge.from >= n || edge.to < 0 || edge.to >= n) return;
+        }
+        this->n = n;
+        vector<size_t> start(n + 1, 0);
+        for (const Edge& edge : edges) {
+            if (edge.from != edge.to) start[edge.to + 1]++;
+        }
+        for (int v = 0; v < n; v++) {
+            start[v + 1] += start[v];
+        }
+        vector<Edge> bucketed(start[n]);
+        vector<size_t> next(start.begin(), start.end() - 1);
+        for (const Edge& edge : edges) {
+            if (edge.from != edge.to) bucketed[next[edge.to]++] = edge;
+        }
+        offsets.reserve(n + 1);
+        for (int v = 0; v < n; v++) {
+            appendGroup(span<Edge>(bucketed.data() + start[v], start[v + 1] - start[v]));
+        }
+        finish();
+    }
+
+    int nodes() const { return n; }
+    size_t size() const { return numEdges; }
+
+    /**
+     * @brief Whether the graph was built, i.e. its constructor accepted the input.
+     */
+    bool valid() const { return n > 0; }
+
+    /**
+     * @brief Memory used by the compressed edges, including the per-node group offsets.
+     */
+    size_t bytes() const { return data.size() + offsets.size() * sizeof(uint64_t); }
+
+    /**
+     * @brief Reads the minimum incoming edge of v from its group header.
+     *
+     * @return false if no edge enters v.
+     */
+    bool minInEdge(int v, int& from, int& weight) const {
+        if (offsets[v] == offsets[v + 1]) return false;
+        GroupHeader header = readHeader(v);
+        from = header.minSource;
+        weight = header.minWeight;
+        return true;
+    }
+
+    /**
+     * @brief Calls visit(const Edge&) for every edge entering v, in increasing source order.
+     */
+    template <class Visit>
+    void forEachInto(int v, Visit&& visit) const {
+        if (offsets[v] == offsets[v + 1]) return;
+        GroupHeader header = readHeader(v);
+        int source = header.firstSource;
+        size_t sourceBit = 0, weightBit = (size_t)(header.count - 1) * header.sourceBits;
+        for (int i = 0; i < header.count; i++) {
+            if (i > 0) {
+                source += (int)readBits(header.packed, sourceBit, header.sourceBits);
+                sourceBit += header.sourceBits;
+            }
+            int64_t weight = header.minWeight + (int64_t)readBits(header.packed, weightBit, header.weightBits);
+            weightBit += header.weightBits;
+            visit(Edge{source, v, (int)weight});
+        }
+    }
+
+    /**
+     * @brief Calls visit(const Edge&) for every edge, grouped by destination.
+     */
+    template <class Visit>
+    void forEach(Visit&& visit) const {
+        for (int v = 0; v < n; v++) {
+            forEachInto(v, visit);
+        }
+    }
+
+    /**
+     * @brief Builds the compressed contracted graph of one Chu-Liu-Edmonds round.
+     *
+     * @param id The 1-based contracted node of every node, as numberContractedNodes produces.
+     * @param numNodes The number of contracted nodes.
+     * @param inWeight The weight of each node's chosen incoming edge, subtracted from the edges entering it.
+     */
+    CompressedGraph contract(span<const int> id, int numNodes, span<const int> inWeight) const {
+        // Group the old nodes by contracted node, so each new group is encoded in one go
+        vector<int> memberStart(numNodes + 1, 0), members(n);
+        for (int v = 0; v < n; v++) {
+            memberStart[id[v]]++;
+        }
+        for (int t = 0; t < numNodes; t++) {
+            memberStart[t + 1] += memberStart[t];
+        }
+        vector<int> next(memberStart.begin(), memberStart.end() - 1);
+        for (int v = 0; v < n; v++) {
+            members[next[id[v] - 1]++] = v;
+        }
+
+        CompressedGraph contracted;
+        contracted.n = numNodes;
+        contracted.offsets.reserve(numNodes + 1);
+        contracted.data.reserve(data.size());
+        vector<Edge> group;
+        for (int t = 0; t < numNodes; t++) {
+            group.clear();
+            for (int m = memberStart[t]; m < memberStart[t + 1]; m++) {
+                int v = members[m];
+                forEachInto(v, [&](const Edge& edge) {
+                    int u = id[edge.from] - 1;
+                    if (u != t) group.push_back({u, t, edge.weight - inWeight[v]});
+                });
+            }
+            contracted.appendGroup(group);
+        }
+        contracted.finish();
+        return contracted;
+    }
+
+private:
+    struct GroupHeader {
+        int count, firstSource, minSource, minWeight;
+        int sourceBits, weightBits;
+        const uint8_t* packed;
+    };
+
+    static int bitWidth(uint64_t maxValue) {
+        return maxValue == 0 ? 0 : 64 - __builtin_clzll(maxValue);
+    }
+
+    static uint64_t readBits(const uint8_t* packed, size_t bit, int width) {
+        uint64_t word;
+        memcpy(&word, packed + bit / 8, sizeof(word));
+        return width == 0 ? 0 : (word >> (bit % 8)) & ((1ULL << width) - 1);
+    }
+
+    void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+            data.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        data.push_back((uint8_t)value);
+    }
+
+    static uint64_t readVarint(const uint8_t*& p) {
+        uint64_t value = 0;
+        for (int shift = 0; ; shift += 7) {
+            uint8_t b = *p++;
+            value |= (uint64_t)(b & 0x7f) << shift;
+            if (b < 0x80) return value;
+        }
+    }
+
+    GroupHeader readHeader(int v) const {
+        const uint8_t* p = data.data() + offsets[v];
+        GroupHeader header;
+        header.count = (int)readVarint(p);
+        header.firstSource = (int)readVarint(p);
+        header.minSource = (int)readVarint(p);
+        uint64_t zigzag = readVarint(p);
+        header.minWeight = (int)(int64_t)((zigzag >> 1) ^ -(zigzag & 1));
+        header.sourceBits = *p++;
+        header.weightBits = *p++;
+        header.packed = p;
+        return header;
+    }
+
+    /**
+     * @brief Encodes the edges entering the next node; sorts them by source in place.
+     */
+    void appendGroup(span<Edge> group) {
+        offsets.push_back(data.size());
+        if (group.empty()) return;
+        sort(group.begin(), group.end(), [](const Edge& a, const Edge& b) { return a.from < b.from; });
+        const Edge* minEdge = &group[0];
+        uint64_t maxGap = 0;
+        for (size_t i = 0; i < group.size(); i++) {
+            if (group[i].weight < minEdge->weight) minEdge = &group[i];
+            if (i > 0) maxGap = max(maxGap, (uint64_t)(group[i].from - group[i - 1].from));
+        }
+        uint64_t maxOffset = 0;
+        for (const Edge& edge : group) {
+            maxOffset = max(maxOffset, (uint64_t)((int64_t)edge.weight - minEdge->weight));
+        }
+        int sourceBits = bitWidth(maxGap), weightBits = bitWidth(maxOffset);
+        writeVarint(group.size());
+        writeVarint(group[0].from);
+        writeVarint(minEdge->from);
+        writeVarint(((uint64_t)(int64_t)minEdge->weight << 1) ^ (uint64_t)((int64_t)minEdge->weight >> 63));
+        data.push_back((uint8_t)sourceBits);
+        data.push_back((uint8_t)weightBits);
+
+        uint64_t buffer = 0;
+        int buffered = 0;
+        auto put = [&](uint64_t value, int width) {
+            if (width == 0) return;
+            buffer |= value << buffered;
+            buffered += width;
+            if (buffered >= 64) {
+                for (int b = 0; b < 8; b++) data.push_back((uint8_t)(buffer >> (8 * b)));
+                buffered -= 64;
+                buffer = buffered ? value >> (width - buffered) : 0;
+            }
+        };
+        for (size_t i = 1; i < group.size(); i++) {
+            put((uint64_t)(group[i].from - group[i - 1].from), sourceBits);
+        }
+        for (const Edge& edge : group) {
+            put((uint64_t)((int64_t)edge.weight - minEdge->weight), weightBits);
+        }
+        for (; buffered > 0; buffered -= 8) {
+            data.push_back((uint8_t)buffer);
+            buffer >>= 8;
+        }
+        numEdges += group.size();
+    }
+
+    void finish() {
+        offsets.push_back(data.size());
+        // Padding so readBits can always load a full word
+        data.insert(data.end(), sizeof(uint64_t), 0);
+        data.shrink_to_fit();
+    }
+
+    int n = 0;
+    size_t numEdges = 0;
+    vector<uint64_t> offsets;
+    vector<uint8_t> data;
+};
+
+/**
+ * @brief Chu-Liu-Edmonds over a compressed graph; every contracted graph is compressed as well.
+ *
+ * Min-incoming-edge selection reads only the group headers; contraction streams through the
+ * groups once per round.
+ *
+ * @param n The number of nodes, which must match graph.nodes().
+ * @param minWeight Receives the total weight of the minimum spanning arborescence on success.
+ * @return EdmondsStatus::Ok, NoArborescence, or InvalidArgument for a bad root, a mismatched n, or
+ *         a graph whose construction was rejected.
+ */
+EdmondsStatus chuLiuEdmonds(int n, int root, const CompressedGraph& graph, int& minWeight) {
+    TraceSpan solveSpan("chuLiuEdmonds");
+    solveSpan.arg("n", n);
+    solveSpan.arg("E", (long long)graph.size());
+    if (!graph.valid() || n != graph.nodes() || root < 0 || root >= n) return EdmondsStatus::InvalidArgument;
+    vector<int> inFrom(n), inWeight(n), cycle(n), visited(n), id(n);
+    CompressedGraph contracted;
+    const CompressedGraph* current = &graph;
+    minWeight = 0;
+
+    for (int round = 0; ; round++) {
+        TraceSpan roundSpan("round");
+        roundSpan.arg("round", round);
+        roundSpan.arg("n", n);
+        roundSpan.arg("E", (long long)current->size());
+        TraceSpan selectSpan("selectMinInEdges");
+        inFrom[root] = -1;
+        inWeight[root] = 0;
+        for (int i = 0; i < n; i++) {
+            if (i != root && !current->minInEdge(i, inFrom[i], inWeight[i])) return EdmondsStatus::NoArborescence;
+        }
+        selectSpan.end();
+
+        TraceSpan detectSpan("detectCycles");
+        int cycleCount = detectCycles(n, root, inFrom, cycle, visited);
+        for (int i = 0; i < n; i++) {
+            minWeight += inWeight[i];
+        }
+        roundSpan.arg("cycles", cycleCount);
+        detectSpan.end();
+        if (cycleCount == 0) return EdmondsStatus::Ok;
+
+        TraceSpan contractSpan("contract");
+        int numNodes = numberContractedNodes(n, inFrom, cycle, id);
+        contracted = current->contract(id, numNodes, inWeight);
+        current = &contracted;
+        root = id[root] - 1;
+        n = numNodes;
+    }
+}
+
+/**
+ * @brief Owns a file descriptor and closes it on destruction.
+ */
+class UniqueFd {
+public:
+    explicit UniqueFd(int fd = -1) : fd(fd) {}
+    UniqueFd(const UniqueFd&) = delete;
+    UniqueFd& operator=(const UniqueFd&) = delete;
+    UniqueFd(UniqueFd&& other) noexcept : fd(exchange(other.fd, -1)) {}
+
+    UniqueFd& operator=(UniqueFd&& other) noexcept {
+        if (this != &other) {
+            if (fd >= 0) ::close(fd);
+            fd = exchange(other.fd, -1);
+        }
+        return *this;
+    }
+
+    ~UniqueFd() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    int get() const { return fd; }
+
+private:
+    int fd;
+};
+
+// Alignment of buffers, offsets and lengths for O_DIRECT transfers
+const size_t IO_ALIGNMENT = 4096;
+
+/**
+ * @brief Switches a descriptor to O_DIRECT, or to sequential-readahead buffered I/O if direct is
+ * false or the file system refuses O_DIRECT (as tmpfs does).
+ *
+ * @return Whether the descriptor now does direct I/O.
+ */
+bool useDirectIo(int fd, bool direct) {
+    int flags = fcntl(fd, F_GETFL);
+    if (direct && flags >= 0 && fcntl(fd, F_SETFL, flags | O_DIRECT) == 0) return true;
+    if (flags >= 0) fcntl(fd, F_SETFL, flags & ~O_DIRECT);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return false;
+}
+
+/**
+ * @brief Aligned heap block for I/O buffers.
+ */
+struct IoBuffer {
+    explicit IoBuffer(size_t bytes)
+        : data(static_cast<uint8_t*>(aligned_alloc(IO_ALIGNMENT, bytes))), size(bytes) {
+        if (!data) throw bad_alloc();
+    }
+    IoBuffer(const IoBuffer&) = delete;
+    IoBuffer& operator=(const IoBuffer&) = delete;
+    ~IoBuffer() { free(data); }
+
+    uint8_t* data;
+    size_t size;
+};
+
+/**
+ * @brief How block reads and writes are issued.
+ */
+enum class IoBackend {
+    IoUring,    // io_uring submission queue, falling back to Threads where the kernel refuses it
+    Threads     // a worker thread issuing pread/pwrite
+};
+
+/**
+ * @brief A fixed number of slots, each holding at most one outstanding read or write.
+ *
+ * Requests run asynchronously to the caller; wait(slot) blocks until the request in the slot
+ * completes. Destroying the queue waits for every outstanding request, so buffers may be freed
+ * afterwards.
+ */
+class IoQueue {
+public:
+    virtual ~IoQueue() = default;
+
+    /**
+     * @brief Starts reading or writing length bytes at offset of fd through buffer in the given slot.
+     */
+    virtual void submit(int slot, bool write, int fd, uint8_t* buffer, size_t length, uint64_t offset) = 0;
+
+    /**
+     * @brief Waits for the request in slot.
+     *
+     * @return The bytes transferred, which is short only at end of file, or -errno.
+     */
+    virtual ssize_t wait(int slot) = 0;
+
+    virtual IoBackend backend() const = 0;
+
+protected:
+    struct Request {
+        bool write;
+        int fd;
+        uint8_t* buffer;
+        size_t length;
+        uint64_t offset;
+    };
+
+    /**
+     * @brief Transfers the part of request past the first done bytes synchronously.
+     *
+     * On an O_DIRECT descriptor each transfer restarts at the IO_ALIGNMENT boundary at or before
+     * done, moving a few bytes twice, since an unaligned offset would fail with EINVAL.
+     */
+    static ssize_t finishSynchronously(const Request& request, size_t done) {
+        int flags = fcntl(request.fd, F_GETFL);
+        bool direct = flags >= 0 && (flags & O_DIRECT);
+        while (done < request.length) {
+            size_t from = direct ? done / IO_ALIGNMENT * IO_ALIGNMENT : done;
+            ssize_t moved = request.write
+                ? pwrite(request.fd, request.buffer + from, request.length - from, request.offset + from)
+                : pread(request.fd, request.buffer + from, request.length - from, request.offset + from);
+            if (moved < 0 && errno == EINTR) continue;
+            if (moved < 0) return -errno;
+            if (from + moved <= done) break;   // end of file
+            done = from + moved;
+        }
+        return done;
+    }
+};
+
+/**
+ * @brief IoQueue on a raw io_uring instance; slot numbers travel as the request user data.
+ */
+class UringIoQueue : public IoQueue {
+public:
+    /**
+     * @brief Sets up a ring with room for depth requests.
+     *
+     * @return nullptr if the kernel does not support or permits io_uring.
+     */
+    static unique_ptr<UringIoQueue> create(int depth) {
+        unique_ptr<UringIoQueue> queue(new UringIoQueue(depth));
+        return queue->ringFd >= 0 ? move(queue) : nullptr;
+    }
+
+    ~UringIoQueue() override {
+        for (int slot = 0; slot < (int)requests.size(); slot++) {
+            if (pending[slot]) wait(slot);
+        }
+        if (sqes) munmap(sqes, sqesBytes);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingBytes);
+        if (sqRing) munmap(sqRing, sqRingBytes);
+        if (ringFd >= 0) ::close(ringFd);
+    }
+
+    void submit(int slot, bool write, int fd, uint8_t* buffer, size_t length, uint64_t offset) override {
+        requests[slot] = {write, fd, buffer, length, offset};
+        pending[slot] = true;
+        unsigned tail = *sqTail;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe& sqe = sqes[index];
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uintptr_t>(buffer);
+        sqe.len = length;
+        sqe.off = offset;
+        sqe.user_data = slot;
+        sqArray[index] = index;
+        atomic_ref<unsigned>(*sqTail).store(tail + 1, memory_order_release);
+        unsubmitted++;
+        int entered;
+        while ((entered = enter(unsubmitted, 0, 0)) < 0 && errno == EINTR) {}
+        if (entered > 0) unsubmitted -= entered;
+    }
+
+    ssize_t wait(int slot) override {
+        while (pending[slot]) {
+            unsigned head = *cqHead;
+            if (head == atomic_ref<unsigned>(*cqTail).load(memory_order_acquire)) {
+                // Entries the kernel refused in submit (EAGAIN, EBUSY) are retried here; until they
+                // are accepted no completion for them can arrive.
+                int entered = enter(unsubmitted, 1, IORING_ENTER_GETEVENTS);
+                if (entered >= 0) unsubmitted -= entered;
+                else if (errno == EAGAIN || errno == EBUSY) this_thread::yield();
+                else if (errno != EINTR) return -errno;
+                continue;
+            }
+            const io_uring_cqe& cqe = cqes[head & *cqMask];
+            int done = (int)cqe.user_data;
+            results[done] = cqe.res;
+            pending[done] = false;
+            atomic_ref<unsigned>(*cqHead).store(head + 1, memory_order_release);
+        }
+        ssize_t result = results[slot];
+        if (result > 0 && (size_t)result < requests[slot].length) {
+            result = finishSynchronously(requests[slot], result);
+        }
+        return result;
+    }
+
+    IoBackend backend() const override { return IoBackend::IoUring; }
+
+private:
+    explicit UringIoQueue(int depth) : requests(depth), pending(depth, false), results(depth, 0) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        ringFd = (int)syscall(__NR_io_uring_setup, depth, &params);
+        if (ringFd < 0) return;
+        sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) sqRingBytes = cqRingBytes = max(sqRingBytes, cqRingBytes);
+        sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+        sqRing = mapRing(sqRingBytes, IORING_OFF_SQ_RING);
+        cqRing = singleMap ? sqRing : mapRing(cqRingBytes, IORING_OFF_CQ_RING);
+        sqes = static_cast<io_uring_sqe*>(mapRing(sqesBytes, IORING_OFF_SQES));
+        if (!sqRing || !cqRing || !sqes) {
+            ::close(exchange(ringFd, -1));
+            return;
+        }
+        uint8_t* sq = static_cast<uint8_t*>(sqRing);
+        uint8_t* cq = static_cast<uint8_t*>(cqRing);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void* mapRing(size_t bytes, off_t offset) {
+        void* ring = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+        return ring == MAP_FAILED ? nullptr : ring;
+    }
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+        return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0);
+    }
+
+    int ringFd = -1;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqRingBytes = 0, cqRingBytes = 0, sqesBytes = 0;
+    unsigned *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned unsubmitted = 0;   // entries written to the submission ring but not yet accepted by the kernel
+    vector<Request> requests;
+    vector<bool> pending;
+    vector<ssize_t> results;
+};
+
+/**
+ * @brief IoQueue served in submission order by one worker thread with blocking pread/pwrite.
+ */
+class ThreadIoQueue : public IoQueue {
+public:
+    explicit ThreadIoQueue(int depth) : requests(depth), pending(depth, false), results(depth, 0) {
+        worker = thread([this] { run(); });
+    }
+
+    ~ThreadIoQueue() override {
+        {
+            lock_guard<mutex> lock(guard);
+            stopping = true;
+        }
+        submitted.notify_one();
+        worker.join();
+    }
+
+    void submit(int slot, bool write, int fd, uint8_t* buffer, size_t length, uint64_t offset) override {
+        {
+            lock_guard<mutex> lock(guard);
+            requests[slot] = {write, fd, buffer, length, offset};
+            pending[slot] = true;
+            order.push_back(slot);
+        }
+        submitted.notify_one();
+    }
+
+    ssize_t wait(int slot) override {
+        unique_lock<mutex> lock(guard);
+        completed.wait(lock, [&] { return !pending[slot]; });
+        return results[slot];
+    }
+
+    IoBackend backend() const override { return IoBackend::Threads; }
+
+private:
+    void run() {
+        unique_lock<mutex> lock(guard);
+        while (true) {
+            submitted.wait(lock, [&] { return stopping || !order.empty(); });
+            if (order.empty()) return;
+            int slot = order.front();
+            order.pop_front();
+            Request request = requests[slot];
+            lock.unlock();
+            ssize_t result = finishSynchronously(request, 0);
+            lock.lock();
+            results[slot] = result;
+            pending[slot] = false;
+            completed.notify_all();
+        }
+    }
+
+    mutex guard;
+    condition_variable submitted, completed;
+    deque<int> order;
+    bool stopping = false;
+    vector<Request> requests;
+    vector<bool> pending;
+    vector<ssize_t> results;
+    thread worker;
+};
+
+/**
+ * @brief Creates a queue of depth slots on the preferred backend, falling back to threads.
+ */
+unique_ptr<IoQueue> makeIoQueue(IoBackend preferred, int depth) {
+    if (preferred == IoBackend::IoUring) {
+        if (unique_ptr<UringIoQueue> queue = UringIoQueue::create(depth)) return queue;
+    }
+    return make_unique<ThreadIoQueue>(depth);
+}
+
+/**
+ * @brief Streams the Edge records stored at [offset, offset + numEdges * sizeof(Edge)) of a file.
+ *
+ * Up to queueDepth blocks are read ahead asynchronously while earlier ones are being visited, so
+ * the disk and the caller's computation overlap. Records may straddle blocks and the start need
+ * not be aligned.
+ */
+class EdgeStreamReader {
+public:
+    EdgeStreamReader(int fd, uint64_t offset, uint64_t numEdges, size_t blockBytes, bool directIo,
+                     IoBackend backend = IoBackend::IoUring, int queueDepth = 4)
+        : fd(fd), offset(offset), numEdges(numEdges),
+          blockBytes((blockBytes + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT), depth(max(queueDepth, 1)),
+          buffer(this->blockBytes * depth), queue(makeIoQueue(backend, depth)),
+          direct(useDirectIo(fd, directIo)) {}
+
+    /**
+     * @brief Calls visit(const Edge&) for every record in file order.
+     *
+     * @return false if the file could not be read to the end.
+     */
+    template <class Visit>
+    bool forEach(Visit&& visit) {
+        uint64_t end = offset + numEdges * sizeof(Edge);
+        uint64_t start = direct ? offset / IO_ALIGNMENT * IO_ALIGNMENT : offset;
+        uint64_t blocks = (end - start + blockBytes - 1) / blockBytes;
+        auto issue = [&](uint64_t block) {
+            if (block < blocks) {
+                int slot = block % depth;
+                queue->submit(slot, false, fd, buffer.data + slot * blockBytes, blockBytes, start + block * blockBytes);
+            }
+        };
+        for (int block = 0; block < depth; block++) issue(block);
+
+        uint8_t carry[sizeof(Edge)];
+        size_t carried = 0;
+        for (uint64_t block = 0; block < blocks; block++) {
+            int slot = block % depth;
+            uint64_t blockStart = start + block * blockBytes;
+            ssize_t got = queue->wait(slot);
+            if (got < (ssize_t)min<uint64_t>(blockBytes, end - blockStart)) return false;
+            bytes += got;
+            const uint8_t* data = buffer.data + slot * blockBytes;
+            const uint8_t* p = data + (block == 0 ? offset - start : 0);
+            const uint8_t* stop = data + min<uint64_t>(got, end - blockStart);
+            if (carried > 0) {
+                size_t take = min<size_t>(sizeof(Edge) - carried, stop - p);
+                memcpy(carry + carried, p, take);
+                carried += take;
+                p += take;
+                if (carried == sizeof(Edge)) {
+                    Edge edge;
+                    memcpy(&edge, carry, sizeof(Edge));
+                    visit(edge);
+                    carried = 0;
+                }
+            }
+            for (; stop - p >= (ptrdiff_t)sizeof(Edge); p += sizeof(Edge)) {
+                Edge edge;
+                memcpy(&edge, p, sizeof(Edge));
+                visit(edge);
+            }
+            if (stop > p) {
+                carried = stop - p;
+                memcpy(carry, p, carried);
+            }
+            issue(block + depth);
+        }
+        return true;
+    }
+
+    uint64_t bytesRead() const { return bytes; }
+    IoBackend backend() const { return queue->backend(); }
+
+private:
+    int fd;
+    uint64_t offset, numEdges;
+    size_t blockBytes;
+    int depth;
+    IoBuffer buffer;
+    unique_ptr<IoQueue> queue;
+    bool direct;
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief Writes Edge records to a file from offset 0 in large block-aligned writes, truncating
+ * whatever the file held before.
+ *
+ * Full blocks are written asynchronously while the next ones fill, with up to queueDepth blocks
+ * in flight.
+ */
+class EdgeStreamWriter {
+public:
+    EdgeStreamWriter(int fd, size_t blockBytes, bool directIo, IoBackend backend = IoBackend::IoUring,
+                     int queueDepth = 4)
+        : fd(fd), blockBytes((blockBytes + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT),
+          depth(max(queueDepth, 1)), buffer(this->blockBytes * depth), queue(makeIoQueue(backend, depth)),
+          inFlight(depth, 0), direct(useDirectIo(fd, directIo)) {
+        failed = ftruncate(fd, 0) != 0;
+    }
+
+    void append(const Edge& edge) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&edge);
+        size_t take = min(sizeof(Edge), blockBytes - used);
+        memcpy(current() + used, bytes, take);
+        used += take;
+        if (used == blockBytes) {
+            flush(blockBytes);
+            memcpy(current(), bytes + take, sizeof(Edge) - take);
+            used = sizeof(Edge) - take;
+        }
+        records++;
+    }
+
+    /**
+     * @brief Writes out the last partial block, waits for all writes and trims the file to the
+     * records written.
+     *
+     * @return false if any write failed.
+     */
+    bool finish() {
+        uint64_t exactBytes = written + used;
+        size_t length = direct ? (used + IO_ALIGNMENT - 1) / IO_ALIGNMENT * IO_ALIGNMENT : used;
+        memset(current() + used, 0, length - used);
+        if (length > 0) flush(length);
+        for (int slot = 0; slot < depth; slot++) reap(slot);
+        failed |= ftruncate(fd, exactBytes) != 0;
+        written = exactBytes;
+        return !failed;
+    }
+
+    uint64_t count() const { return records; }
+    uint64_t bytesWritten() const { return written; }
+    IoBackend backend() const { return queue->backend(); }
+
+private:
+    uint8_t* current() { return buffer.data + slot * blockBytes; }
+
+    void flush(size_t length) {
+        queue->submit(slot, true, fd, current(), length, written);
+        inFlight[slot] = length;
+        written += length;
+        used = 0;
+        slot = (slot + 1) % depth;
+        reap(slot);
+    }
+
+    void reap(int slot) {
+        if (inFlight[slot] > 0) {
+            failed |= queue->wait(slot) != (ssize_t)inFlight[slot];
+            inFlight[slot] = 0;
+        }
+    }
+
+    int fd;
+    size_t blockBytes;
+    int depth;
+    IoBuffer buffer;
+    unique_ptr<IoQueue> queue;
+    vector<size_t> inFlight;
+    bool direct;
+    bool failed = false;
+    int slot = 0;
+    size_t used = 0;
+    uint64_t written = 0, records = 0;
+};
+
+/**
+ * @brief Tuning for chuLiuEdmondsSemiExternal.
+ */
+struct SemiExternalOptions {
+    string tempDirectory = filesystem::temp_directory_path().string();  // where contracted graphs are spilled
+    size_t blockBytes = 4 << 20;                                        // size of each read and write
+    int queueDepth = 4;                                                 // blocks in flight per stream
+    IoBackend ioBackend = IoBackend::IoUring;                           // how blocks are read and written
+    bool directIo = false;                                              // bypass the page cache with O_DIRECT
+};
+
+/**
+ * @brief I/O counters of a chuLiuEdmondsSemiExternal solve.
+ */
+struct SemiExternalStats {
+    int rounds = 0;
+    uint64_t bytesRead = 0, bytesWritten = 0;
+    IoBackend ioBackend = IoBackend::Threads;   // the backend actually used, after any fallback
+};
+
+/**
+ * @brief Chu-Liu-Edmonds for graphs whose edges do not fit in memory but whose nodes do.
+ *
+ * Node state (chosen in-edges, cycles, the contraction map) stays in RAM. The edges are read
+ * sequentially from the graph file, and each contracted graph is written sequentially to an
+ * unlinked scratch file in options.tempDirectory. The next round's minimum incoming edges are
+ * picked while a contracted graph is written, so every round reads its edges exactly once.
+ * Reads and writes go through io_uring (or a worker thread) with options.queueDepth blocks in
+ * flight, overlapping the disk with selection and contraction.
+ *
+ * @param graphPath A file in the binary graph file format (see writeGraphFile).
+ * @param minWeight Receives the total weight of the minimum spanning arborescence on success.
+ * @param stats If non-null, receives the number of rounds and bytes transferred.
+ * @return EdmondsStatus::Ok, NoArborescence, InvalidArgument for a malformed file, or IoError.
+ */
+EdmondsStatus chuLiuEdmondsSemiExternal(const string& graphPath, int& minWeight,
+                                        const SemiExternalOptions& options = {},
+                                        SemiExternalStats* stats = nullptr) {
+    UniqueFd input(::open(graphPath.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat info;
+    GraphFileHeader header;
+    if (input.get() < 0 || fstat(input.get(), &info) != 0 ||
+        pread(input.get(), &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        return EdmondsStatus::IoError;
+    }
+    size_t edgeOffset = graphFileEdgeOffset(header, (size_t)info.st_size);
+    if (edgeOffset == 0) return EdmondsStatus::InvalidArgument;
+    {
+        vector<uint64_t> offsets((size_t)header.n + 1);
+        ssize_t offsetBytes = offsets.size() * sizeof(uint64_t);
+        if (pread(input.get(), offsets.data(), offsetBytes, sizeof(header)) != offsetBytes) {
+            return EdmondsStatus::IoError;
+        }
+        if (!graphFileOffsetsValid(offsets, header.numEdges)) return EdmondsStatus::InvalidArgument;
+    }
+
+    UniqueFd scratch[2];
+    for (UniqueFd& file : scratch) {
+        string path = options.tempDirectory + "/edmonds-spill-XXXXXX";
+        file = UniqueFd(mkstemp(path.data()));
+        if (file.get() < 0) return EdmondsStatus::IoError;
+        unlink(path.c_str());
+    }
+
+    int n = header.n, root = header.root;
+    TraceSpan solveSpan("chuLiuEdmondsSemiExternal");
+    solveSpan.arg("n", n);
+    solveSpan.arg("E", (long long)header.numEdges);
+    SemiExternalStats counters;
+    vector<int> inFrom(n, -1), inWeight(n), nextFrom(n), nextWeight(n), cycle(n), visited(n), id(n);
+    auto consider = [](vector<int>& from, vector<int>& weight, const Edge& edge) {
+        if (edge.from != edge.to && (from[edge.to] == -1 || edge.weight < weight[edge.to])) {
+            from[edge.to] = edge.from;
+            weight[edge.to] = edge.weight;
+        }
+    };
+
+    {
+        TraceSpan selectSpan("selectMinInEdges");
+        bool valid = true;
+        EdgeStreamReader reader(input.get(), edgeOffset, header.numEdges, options.blockBytes, options.directIo,
+                                options.ioBackend, options.queueDepth);
+        counters.ioBackend = reader.backend();
+        bool ok = reader.forEach([&](const Edge& edge) {
+            if (edge.from < 0 || edge.from >= n || edge.to < 0 || edge.to >= n) {
+                valid = false;
+                return;
+            }
+            consider(inFrom, inWeight, edge);
+        });
+        counters.bytesRead += reader.bytesRead();
+        if (!ok) return EdmondsStatus::IoError;
+        if (!valid) return EdmondsStatus::InvalidArgument;
+    }
+
+    int currentFd = input.get();
+    uint64_t currentOffset = edgeOffset, currentEdges = header.numEdges;
+    minWeight = 0;
+    EdmondsStatus status;
+    for (int round = 0; ; round++) {
+        TraceSpan roundSpan("round");
+        roundSpan.arg("round", round);
+        roundSpan.arg("n", n);
+        roundSpan.arg("E", (long long)currentEdges);
+        counters.rounds++;
+        bool reachable = true;
+        for (int i = 0; i < n; i++) {
+            if (i != root && inFrom[i] == -1) reachable = false;
+        }
+        if (!reachable) {
+            status = EdmondsStatus::NoArborescence;
+            break;
+        }
+
+        TraceSpan detectSpan("detectCycles");
+        int cycleCount = detectCycles(n, root, inFrom, cycle, visited);
+        for (int i = 0; i < n; i++) {
+            if (i != root) minWeight += inWeight[i];
+        }
+        roundSpan.arg("cycles", cycleCount);
+        detectSpan.end();
+        if (cycleCount == 0) {
+            status = EdmondsStatus::Ok;
+            break;
+        }
+
+        TraceSpan contractSpan("contract");
+        int numNodes = numberContractedNodes(n, inFrom, cycle, id);
+        fill(nextFrom.begin(), nextFrom.begin() + numNodes, -1);
+        EdgeStreamReader reader(currentFd, currentOffset, currentEdges, options.blockBytes, options.directIo,
+                                options.ioBackend, options.queueDepth);
+        EdgeStreamWriter writer(scratch[round % 2].get(), options.blockBytes, options.directIo,
+                                options.ioBackend, options.queueDepth);
+        bool ok = reader.forEach([&](const Edge& edge) {
+            int u = id[edge.from] - 1;
+            int v = id[edge.to] - 1;
+            if (u != v) {
+                Edge contracted = {u, v, edge.weight - inWeight[edge.to]};
+                writer.append(contracted);
+                consider(nextFrom, nextWeight, contracted);
+            }
+        });
+        ok = writer.finish() && ok;
+        counters.bytesRead += reader.bytesRead();
+        counters.bytesWritten += writer.bytesWritten();
+        if (!ok) {
+            status = EdmondsStatus::IoError;
+            break;
+        }
+        swap(inFrom, nextFrom);
+        swap(inWeight, nextWeight);
+        root = id[root] - 1;
+        n = numNodes;
+        currentFd = scratch[round % 2].get();
+        currentOffset = 0;
+        currentEdges = writer.count();
+    }
+    if (stats) *stats = counters;
+    return status;
+}
+
+// Batch file: a BatchFileHeader, then any number of graphs back to back, each a
+// BatchGraphHeader followed by its numEdges Edge records. Graphs can be appended
+// without rewriting what came before, and read one at a time.
+const char BATCH_FILE_MAGIC[4] = {'E', 'D', 'M', 'B'};
+const uint32_t BATCH_FILE_VERSION = 1;
+
+struct BatchFileHeader {
+    char magic[4];
+    uint32_t version;
+};
+
+struct BatchGraphHeader {
+    int32_t n;
+    int32_t root;
+    uint64_t numEdges;
+};
+
+static_assert(sizeof(BatchFileHeader) == 8 && sizeof(BatchGraphHeader) == 16,
+              "batch file headers are part of the on-disk format");
+
+/**
+ * @brief Appends graphs to a new batch file.
+ */
+class BatchFileWriter {
+public:
+    bool open(const string& path) {
+        out.open(path, ios::binary | ios::trunc);
+        BatchFileHeader header = {};
+        memcpy(header.magic, BATCH_FILE_MAGIC, sizeof(header.magic));
+        header.version = BATCH_FILE_VERSION;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return bool(out);
+    }
+
+    bool append(int n, int root, span<const Edge> edges) {
+        BatchGraphHeader header = {n, root, edges.size()};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(edges.data()), edges.size() * sizeof(Edge));
+        return bool(out);
+    }
+
+    bool close() {
+        out.close();
+        return !out.fail();
+    }
+
+private:
+    ofstream out;
+};
+
+/**
+ * @brief One graph of a batch file; index is its position in the file.
+ */
+struct BatchGraph {
+    uint64_t index = 0;
+    int n = 0, root = 0;
+    vector<Edge> edges;
+};
+
+/**
+ * @brief Reads the graphs of a batch file in order.
+ */
+class BatchFileReader {
+public:
+    /**
+     * @param maxNodes Graphs with more nodes are treated as malformed, so that a corrupt header
+     *                 cannot make the solver allocate node arrays of any size.
+     */
+    explicit BatchFileReader(int maxNodes = 1 << 24) : maxNodes(maxNodes) {}
+
+    bool open(const string& path) {
+        in.open(path, ios::binary);
+        BatchFileHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            memcmp(header.magic, BATCH_FILE_MAGIC, sizeof(header.magic)) != 0 || header.version != BATCH_FILE_VERSION) {
+            error = true;
+            return false;
+        }
+        error_code ec;
+        remaining = filesystem::file_size(path, ec) - sizeof(header);
+        return !ec;
+    }
+
+    /**
+     * @brief Reads the next graph into graph, reusing its edge storage.
+     *
+     * @return false at the end of the file or at a malformed graph; failed() tells them apart.
+     */
+    bool next(BatchGraph& graph) {
+        if (error || remaining == 0) return false;
+        BatchGraphHeader header;
+        if (remaining < sizeof(header) || !in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            error = true;
+            return false;
+        }
+        remaining -= sizeof(header);
+        if (header.n > maxNodes || header.numEdges > remaining / sizeof(Edge)) {
+            error = true;
+            return false;
+        }
+        graph.index = index++;
+        graph.n = header.n;
+        graph.root = header.root;
+        graph.edges.resize(header.numEdges);
+        in.read(reinterpret_cast<char*>(graph.edges.data()), header.numEdges * sizeof(Edge));
+        remaining -= header.numEdges * sizeof(Edge);
+        error = !in;
+        return !error;
+    }
+
+    bool failed() const { return error; }
+
+private:
+    ifstream in;
+    int maxNodes;
+    uint64_t remaining = 0, index = 0;
+    bool error = false;
+};
+
+/**
+ * @brief Bounded lock-free queue between exactly one producer thread and one consumer thread.
+ *
+ * Each side caches the other side's index and only rereads it when the queue looks full or empty,
+ * so the two threads share a cache line only when they must.
+ */
+template <class T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots(bit_ceil(max<size_t>(capacity, 1))), mask(slots.size() - 1) {}
+
+    /**
+     * @brief Moves value into the queue unless it is full.
+     */
+    bool tryPush(T& value) {
+        size_t tail = tailIndex.load(memory_order_relaxed);
+        if (tail - cachedHead == slots.size()) {
+            cachedHead = headIndex.load(memory_order_acquire);
+            if (tail - cachedHead == slots.size()) return false;
+        }
+        slots[tail & mask] = move(value);
+        tailIndex.store(tail + 1, memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Moves the oldest element into value unless the queue is empty.
+     */
+    bool tryPop(T& value) {
+        size_t head = headIndex.load(memory_order_relaxed);
+        if (head == cachedTail) {
+            cachedTail = tailIndex.load(memory_order_acquire);
+            if (head == cachedTail) return false;
+        }
+        value = move(slots[head & mask]);
+        headIndex.store(head + 1, memory_order_release);
+        return true;
+    }
+
+    void push(T value) {
+        while (!tryPush(value)) this_thread::yield();
+    }
+
+    T pop() {
+        T value;
+        while (!tryPop(value)) this_thread::yield();
+        return value;
+    }
+
+private:
+    vector<T> slots;
+    size_t mask;
+    alignas(64) atomic<size_t> headIndex{0};   // written by the consumer
+    size_t cachedTail = 0;                     // the consumer's copy of tailIndex
+    alignas(64) atomic<size_t> tailIndex{0};   // written by the producer
+    size_t cachedHead = 0;                     // the producer's copy of headIndex
+};
+
+/**
+ * @brief The solver a batch is run through.
+ */
+enum class BatchEngine {
+    ChuLiuEdmonds,  // the round-based solver, reusing one workspace across graphs; totals only
+    Tarjan          // chuLiuEdmondsTarjan; totals and parent arrays
+};
+
+/**
+ * @brief The outcome of solving one graph of a batch.
+ */
+struct BatchResult {
+    uint64_t index = 0;
+    EdmondsStatus status = EdmondsStatus::Ok;
+    int total = 0;
+    vector<int> parent;     // empty unless the engine reports parents and the solve succeeded
+};
+
+/**
+ * @brief A 128-bit graph fingerprint.
+ */
+struct GraphHash {
+    uint64_t low = 0, high = 0;
+
+    bool operator==(const GraphHash&) const = default;
+};
+
+/**
+ * @brief Hashes (n, root, edges) to 128 bits, independently of the order of the edges.
+ *
+ * Each edge is mixed on its own into two 64-bit lanes with different constants and the lanes are
+ * summed, so the loop carries no dependency between edges and the compiler can vectorize it; a
+ * re-parsed graph whose edges come out in another order hashes the same.
+ */
+GraphHash hashGraph(int n, int root, span<const Edge> edges) {
+    auto finalize = [](uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        return x ^ (x >> 33);
+    };
+    uint64_t low = 0, high = 0;
+    for (const Edge& edge : edges) {
+        uint64_t x = (uint64_t)(uint32_t)edge.from << 32 | (uint32_t)edge.to;
+        uint64_t y = (uint32_t)edge.weight;
+        uint64_t a = (x ^ (y * 0x9e3779b97f4a7c15ULL)) * 0xbf58476d1ce4e5b9ULL;
+        uint64_t b = (x + (y ^ 0x94d049bb133111ebULL)) * 0x2545f4914f6cdd1dULL;
+        low += a ^ (a >> 31);
+        high += b ^ (b >> 29);
+    }
+    uint64_t shape = (uint64_t)(uint32_t)n << 32 | (uint32_t)root;
+    return {finalize(low ^ shape ^ edges.size()), finalize(high + finalize(shape + edges.size()))};
+}
+
+/**
+ * @brief A bounded, thread-safe cache of solve results keyed by GraphHash.
+ *
+ * The cache is split into shards, each with its own lock, LRU list and share of the byte budget,
+ * so concurrent solvers rarely contend. An entry is charged its parent array plus a fixed
+ * overhead; inserting evicts the least recently used entries of the shard until it fits.
+ */
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacityBytes = 64 << 20, int shardCount = 16)
+        : shards(max(shardCount, 1)), shardCapacity(capacityBytes / max(shardCount, 1)) {}
+
+    /**
+     * @brief Copies the cached result for hash into result (leaving result.index untouched).
+     *
+     * @param needParents Whether the caller reports parent arrays, so that a solved entry stored
+     *                    without one (by a totals-only engine) counts as a miss.
+     * @return Whether there was a usable one.
+     */
+    bool lookup(const GraphHash& hash, BatchResult& result, bool needParents = false) {
+        Shard& shard = shardFor(hash);
+        {
+            lock_guard<mutex> lock(shard.guard);
+            auto found = shard.index.find(hash);
+            if (found != shard.index.end() &&
+                !(needParents && found->second->status == EdmondsStatus::Ok && found->second->parent.empty())) {
+                shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+                const Entry& entry = *found->second;
+                result.status = entry.status;
+                result.total = entry.total;
+                result.parent = entry.parent;
+                hitCount++;
+                return true;
+            }
+        }
+        missCount++;
+        return false;
+    }
+
+    void insert(const GraphHash& hash, const BatchResult& result) {
+        size_t cost = entryBytes(result.parent.size());
+        if (cost > shardCapacity) return;
+        Shard& shard = shardFor(hash);
+        lock_guard<mutex> lock(shard.guard);
+        auto found = shard.index.find(hash);
+        if (found != shard.index.end()) {
+            shard.bytes -= entryBytes(found->second->parent.size());
+            shard.entries.erase(found->second);
+            shard.index.erase(found);
+        }
+        while (shard.bytes + cost > shardCapacity) {
+            const Entry& oldest = shard.entries.back();
+            shard.bytes -= entryBytes(oldest.parent.size());
+            shard.index.erase(oldest.hash);
+            shard.entries.pop_back();
+            evictionCount++;
+        }
+        shard.entries.push_front({hash, result.status, result.total, result.parent});
+        shard.index[hash] = shard.entries.begin();
+        shard.bytes += cost;
+    }
+
+    uint64_t hits() const { return hitCount; }
+    uint64_t misses() const { return missCount; }
+    uint64_t evictions() const { return evictionCount; }
+
+    size_t bytes() {
+        size_t total = 0;
+        for (Shard& shard : shards) {
+            lock_guard<mutex> lock(shard.guard);
+            total += shard.bytes;
+        }
+        return total;
+    }
+
+private:
+    struct Entry {
+        GraphHash hash;
+        EdmondsStatus status;
+        int total;
+        vector<int> parent;
+    };
+
+    struct HashOfHash {
+        size_t operator()(const GraphHash& hash) const { return hash.high; }
+    };
+
+    struct Shard {
+        mutex guard;
+        list<Entry> entries;    // most recently used first
+        unordered_map<GraphHash, list<Entry>::iterator, HashOfHash> index;
+        size_t bytes = 0;
+    };
+
+    // Charge for the list node, the index slot and the parent array's header
+    static const size_t ENTRY_OVERHEAD = 128;
+
+    static size_t entryBytes(size_t parentCount) { return ENTRY_OVERHEAD + parentCount * sizeof(int); }
+
+    Shard& shardFor(const GraphHash& hash) { return shards[hash.low % shards.size()]; }
+
+    vector<Shard> shards;
+    size_t shardCapacity;
+    atomic<uint64_t> hitCount{0}, missCount{0}, evictionCount{0};
+};
+
+/**
+ * @brief Solves graphs one after another with one engine, reusing its scratch memory across solves,
+ * optionally answering repeated graphs from a ResultCache.
+ */
+class BatchSolver {
+public:
+    explicit BatchSolver(BatchEngine engine, ResultCache* cache = nullptr) : engine(engine), cache(cache) {}
+
+    /**
+     * @brief Solves one graph into result, leaving result.index untouched.
+     *
+     * @param stop If non-null, lets the solve end early as Cancelled or TimedOut; such results
+     *             are not cached.
+     */
+    void solve(int n, int root, span<const Edge> edges, BatchResult& result, const SolveStop* stop = nullptr) {
+        if (!cache) {
+            solveUncached(n, root, edges, result, stop);
+            return;
+        }
+        GraphHash hash = hashGraph(n, root, edges);
+        if (cache->lookup(hash, result, engine == BatchEngine::Tarjan)) return;
+        solveUncached(n, root, edges, result, stop);
+        if (result.status != EdmondsStatus::Cancelled && result.status != EdmondsStatus::TimedOut) {
+            cache->insert(hash, result);
+        }
+    }
+
+private:
+    void solveUncached(int n, int root, span<const Edge> edges, BatchResult& result, const SolveStop* stop) {
+        result.parent.clear();
+        if (engine == BatchEngine::Tarjan) {
+            result.status = chuLiuEdmondsTarjan(n, root, edges, result.total, &result.parent, stop);
+            return;
+        }
+        EdmondsWorkspaceSize size = requiredWorkspace(n, edges.size());
+        nodeInts.resize(max(nodeInts.size(), EdmondsWorkspace::NODE_ARRAYS * size.nodeInts));
+        scratch.resize(max(scratch.size(), size.scratchEdges));
+        span<int> ints(nodeInts);
+        EdmondsWorkspace workspace = {ints.subspan(0, size.nodeInts), ints.subspan(size.nodeInts, size.nodeInts),
+                                      ints.subspan(2 * size.nodeInts, size.nodeInts),
+                                      ints.subspan(3 * size.nodeInts, size.nodeInts),
+                                      ints.subspan(4 * size.nodeInts, size.nodeInts), scratch};
+        result.status = chuLiuEdmonds(n, root, edges, workspace, result.total, stop);
+    }
+
+    BatchEngine engine;
+    ResultCache* cache;
+    vector<int> nodeInts;
+    vector<Edge> scratch;
+};
+
+struct BatchPipelineOptions {
+    size_t queueCapacity = 8;   // graphs (and results) buffered between two stages
+    BatchEngine engine = BatchEngine::Tarjan;
+    ResultCache* cache = nullptr;
+    int maxNodes = 1 << 24;     // a graph with more nodes is malformed (see BatchFileReader)
+};
+
+/**
+ * @brief Solves every graph of a batch file with a three-stage pipeline.
+ *
+ * A reader thread decodes graphs, a solver thread solves them and the calling thread hands the
+ * results, in file order, to sink, which may move from them. The stages are connected by bounded SpscQueues, so reading the
+ * next graph overlaps solving the current one, and at most about 2 * queueCapacity graphs and
+ * results are held in memory whatever the size of the file. A graph whose solve runs out of memory
+ * gets EdmondsStatus::OutOfMemory and the batch carries on.
+ *
+ * @return false if the file cannot be opened or holds a malformed graph, including one with more
+ *         than options.maxNodes nodes; the results of the graphs before it are still delivered.
+ */
+bool runBatchPipeline(const string& path, const function<void(BatchResult&)>& sink,
+                      const BatchPipelineOptions& options = {}) {
+    BatchFileReader file(options.maxNodes);
+    if (!file.open(path)) return false;
+    // a null pointer marks the end of each stream
+    SpscQueue<unique_ptr<BatchGraph>> graphs(options.queueCapacity);
+    SpscQueue<unique_ptr<BatchResult>> results(options.queueCapacity);
+
+    thread reader([&] {
+        TraceSpan readSpan("batchRead");
+        auto graph = make_unique<BatchGraph>();
+        while (file.next(*graph)) {
+            graphs.push(move(graph));
+            graph = make_unique<BatchGraph>();
+        }
+        graphs.push(nullptr);
+    });
+
+    thread solver([&] {
+        TraceSpan solveSpan("batchSolve");
+        BatchSolver engine(options.engine, options.cache);
+        while (unique_ptr<BatchGraph> graph = graphs.pop()) {
+            auto result = make_unique<BatchResult>();
+            try {
+                engine.solve(graph->n, graph->root, graph->edges, *result);
+            } catch (const bad_alloc&) {
+                *result = {};
+                result->status = EdmondsStatus::OutOfMemory;
+            }
+            result->index = graph->index;
+            results.push(move(result));
+        }
+        results.push(nullptr);
+    });
+
+    {
+        TraceSpan writeSpan("batchWrite");
+        while (unique_ptr<BatchResult> result = results.pop()) sink(*result);
+    }
+    reader.join();
+    solver.join();
+    return !file.failed();
+}
+
+// Result file: a ResultFileHeader, then one record per solved graph: a ResultRecordHeader
+// followed by parentCount int32 parents, zero-padded to a multiple of 8 bytes so that every
+// record header stays 8-byte aligned in a mapped file.
+const char RESULT_FILE_MAGIC[4] = {'E', 'D', 'M', 'R'};
+const uint32_t RESULT_FILE_VERSION = 1;
+
+struct ResultFileHeader {
+    char magic[4];
+    uint32_t version;
+};
+
+struct ResultRecordHeader {
+    uint64_t index;         // position of the graph in its batch
+    int32_t status;         // an EdmondsStatus
+    int32_t parentCount;    // n, or 0 if no parent array was produced
+    int64_t total;          // arborescence weight; 0 unless status is Ok
+};
+
+static_assert(sizeof(ResultFileHeader) == 8 && sizeof(ResultRecordHeader) == 24,
+              "result file headers are part of the on-disk format");
+
+/**
+ * @brief Writes every byte of parts in order, resuming after short writes.
+ *
+ * Sockets are written with sendmsg, so that a closed peer fails the call instead of raising SIGPIPE.
+ */
+bool writeGathered(int fd, vector<iovec> parts, bool isSocket = false) {
+    for (size_t first = 0; first < parts.size();) {
+        int count = (int)min<size_t>(parts.size() - first, IOV_MAX);
+        ssize_t written;
+        if (isSocket) {
+            msghdr message = {};
+            message.msg_iov = &parts[first];
+            message.msg_iovlen = count;
+            written = sendmsg(fd, &message, MSG_NOSIGNAL);
+        } else {
+            written = writev(fd, &parts[first], count);
+        }
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0) return false;
+        for (; first < parts.size() && (size_t)written >= parts[first].iov_len; first++) {
+            written -= parts[first].iov_len;
+        }
+        if (written > 0) {
+            parts[first].iov_base = static_cast<char*>(parts[first].iov_base) + written;
+            parts[first].iov_len -= written;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Writes BatchResults to a result file without formatting anything as text.
+ *
+ * Appended results are kept, not copied, until a flush gathers their headers and parent arrays
+ * into a single writev, which happens once about flushBytes are pending.
+ */
+class ResultFileWriter {
+public:
+    explicit ResultFileWriter(size_t flushBytes = 1 << 20) : flushBytes(flushBytes) {}
+    ResultFileWriter(const ResultFileWriter&) = delete;
+    ResultFileWriter& operator=(const ResultFileWriter&) = delete;
+
+    ~ResultFileWriter() { close(); }
+
+    bool open(const string& path) {
+        file = UniqueFd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+        ResultFileHeader header = {};
+        memcpy(header.magic, RESULT_FILE_MAGIC, sizeof(header.magic));
+        header.version = RESULT_FILE_VERSION;
+        failed = file.get() < 0;
+        if (!failed) writeAll({iovec{&header, sizeof(header)}});
+        return !failed;
+    }
+
+    /**
+     * @brief Takes ownership of result and queues it for writing.
+     */
+    void append(BatchResult&& result) {
+        int32_t parentCount = result.status == EdmondsStatus::Ok ? (int32_t)result.parent.size() : 0;
+        headers.push_back({result.index, (int32_t)result.status, parentCount,
+                           result.status == EdmondsStatus::Ok ? (int64_t)result.total : 0});
+        pendingBytes += sizeof(ResultRecordHeader) + paddedParentBytes(parentCount);
+        pending.push_back(move(result));
+        if (pendingBytes >= flushBytes || 3 * pending.size() + 3 > IOV_MAX) flush();
+    }
+
+    /**
+     * @brief Writes out every queued result.
+     *
+     * @return false if any write so far has failed.
+     */
+    bool flush() {
+        vector<iovec> parts;
+        parts.reserve(3 * pending.size());
+        for (size_t r = 0; r < pending.size(); r++) {
+            parts.push_back({&headers[r], sizeof(ResultRecordHeader)});
+            size_t bytes = headers[r].parentCount * sizeof(int32_t);
+            if (bytes > 0) parts.push_back({pending[r].parent.data(), bytes});
+            size_t padding = paddedParentBytes(headers[r].parentCount) - bytes;
+            if (padding > 0) parts.push_back({const_cast<char*>(ZEROS), padding});
+        }
+        if (!parts.empty() && !failed) writeAll(move(parts));
+        pending.clear();
+        headers.clear();
+        pendingBytes = 0;
+        return !failed;
+    }
+
+    bool close() {
+        if (file.get() < 0) return !failed;
+        flush();
+        file = UniqueFd();
+        return !failed;
+    }
+
+private:
+    static constexpr char ZEROS[8] = {};
+
+    static size_t paddedParentBytes(int32_t parentCount) {
+        return (parentCount * sizeof(int32_t) + 7) / 8 * 8;
+    }
+
+    void writeAll(vector<iovec> parts) {
+        failed |= !writeGathered(file.get(), move(parts));
+    }
+
+    UniqueFd file;
+    size_t flushBytes;
+    vector<BatchResult> pending;
+    vector<ResultRecordHeader> headers;
+    size_t pendingBytes = 0;
+    bool failed = false;
+};
+
+/**
+ * @brief One record of a result file; parent points into the mapped file.
+ */
+struct ResultView {
+    uint64_t index = 0;
+    EdmondsStatus status = EdmondsStatus::Ok;
+    long long total = 0;
+    span<const int32_t> parent;
+};
+
+/**
+ * @brief Reads a result file in place through a memory mapping.
+ */
+class ResultFileReader {
+public:
+    bool open(const string& path) {
+        error = !file.open(path) || file.size() < sizeof(ResultFileHeader) ||
+                memcmp(file.data(), RESULT_FILE_MAGIC, sizeof(RESULT_FILE_MAGIC)) != 0 ||
+                reinterpret_cast<const ResultFileHeader*>(file.data())->version != RESULT_FILE_VERSION;
+        position = sizeof(ResultFileHeader);
+        return !error;
+    }
+
+    /**
+     * @brief Reads the next record into result.
+     *
+     * @return false at the end of the file or at a malformed record; failed() tells them apart.
+     */
+    bool next(ResultView& result) {
+        if (error || position == file.size()) return false;
+        if (file.size() - position < sizeof(ResultRecordHeader)) return fail();
+        const ResultRecordHeader* header = reinterpret_cast<const ResultRecordHeader*>(file.data() + position);
+        size_t parentBytes = (size_t)max(header->parentCount, 0) * sizeof(int32_t);
+        size_t recordBytes = sizeof(ResultRecordHeader) + (parentBytes + 7) / 8 * 8;
+        if (header->parentCount < 0 || file.size() - position < recordBytes) return fail();
+        result.index = header->index;
+        result.status = (EdmondsStatus)header->status;
+        result.total = header->total;
+        result.parent = {reinterpret_cast<const int32_t*>(header + 1), (size_t)header->parentCount};
+        position += recordBytes;
+        return true;
+    }
+
+    bool failed() const { return error; }
+
+private:
+    bool fail() {
+        error = true;
+        return false;
+    }
+
+    MappedFile file;
+    size_t position = 0;
+    bool error = false;
+};
+
+/**
+ * @brief Solves every graph of a batch file and writes the results to a result file.
+ *
+ * @return false if the batch file is malformed or the result file cannot be written.
+ */
+bool solveBatchFile(const string& batchPath, const string& resultPath, const BatchPipelineOptions& options = {}) {
+    ResultFileWriter writer;
+    if (!writer.open(resultPath)) return false;
+    bool solved = runBatchPipeline(batchPath, [&](BatchResult& result) { writer.append(move(result)); }, options);
+    return writer.close() && solved;
+}
+
+// Solver daemon protocol, over a Unix stream socket. A client sends requests one at a time,
+// each a DaemonRequest, and reads one reply per request:
+//  - DAEMON_SOLVE: numEdges Edge records follow inline, or, with DAEMON_SHARED_MEMORY, the
+//    request carries (SCM_RIGHTS) a memfd holding them, which must be sealed with at least
+//    F_SEAL_SHRINK and F_SEAL_WRITE. The reply is a DaemonReply followed by
+//    parentCount int32 parents.
+//  - DAEMON_STATS: the reply is a DaemonStats.
+const uint32_t DAEMON_MAGIC = 0x514d4445;   // "EDMQ"
+const uint32_t DAEMON_SOLVE = 1;
+const uint32_t DAEMON_STATS = 2;
+const uint32_t DAEMON_WANT_PARENTS = 1;
+const uint32_t DAEMON_SHARED_MEMORY = 2;
+
+struct DaemonRequest {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t flags;
+    int32_t n;
+    int32_t root;
+    uint32_t reserved;
+    uint64_t numEdges;
+};
+
+struct DaemonReply {
+    int32_t status;         // an EdmondsStatus
+    int32_t parentCount;
+    int64_t total;
+};
+
+struct DaemonStats {
+    uint64_t requests;          // solve requests answered
+    uint64_t batches;           // micro-batches solved
+    uint64_t queueDepth;        // solve requests waiting right now
+    uint64_t maxQueueDepth;
+    double uptimeSeconds;
+    double requestsPerSecond;   // requests / uptimeSeconds
+    double p50Micros, p90Micros, p99Micros;  // over the most recent requests, arrival to reply
+};
+
+static_assert(sizeof(DaemonRequest) == 32 && sizeof(DaemonReply) == 16 && sizeof(DaemonStats) == 72,
+              "daemon messages are part of the wire protocol");
+
+/**
+ * @brief Sends all bytes, without raising SIGPIPE on a closed peer.
+ */
+bool sendAll(int fd, const void* data, size_t bytes) {
+    const char* p = static_cast<const char*>(data);
+    while (bytes > 0) {
+        ssize_t sent = send(fd, p, bytes, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+        p += sent;
+        bytes -= sent;
+    }
+    return true;
+}
+
+/**
+ * @brief Receives exactly bytes bytes. If passedFd is non-null, it receives a descriptor sent
+ * alongside them with SCM_RIGHTS, or -1.
+ */
+bool receiveAll(int fd, void* data, size_t bytes, int* passedFd = nullptr) {
+    if (passedFd) *passedFd = -1;
+    char* p = static_cast<char*>(data);
+    while (bytes > 0) {
+        iovec part = {p, bytes};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        msghdr message = {};
+        message.msg_iov = &part;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        ssize_t received = recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level == SOL_SOCKET && header->cmsg_type == SCM_RIGHTS) {
+                int descriptor;
+                memcpy(&descriptor, CMSG_DATA(header), sizeof(int));
+                if (passedFd && *passedFd < 0) *passedFd = descriptor;
+                else ::close(descriptor);
+            }
+        }
+        p += received;
+        bytes -= received;
+    }
+    return true;
+}
+
+struct SolverDaemonOptions {
+    size_t maxBatch = 64;                       // solve requests per micro-batch
+    chrono::microseconds batchWindow{200};      // how long a batch waits to fill once its first request is in
+    BatchEngine engine = BatchEngine::Tarjan;
+    uint64_t maxInlineEdges = 1 << 22;          // larger graphs must come through shared memory
+    int maxNodes = 1 << 24;                     // requests for larger graphs are refused
+    ResultCache* cache = nullptr;               // answers repeated graphs without solving them
+};
+
+/**
+ * @brief Serves solve and stats requests on a Unix domain socket.
+ *
+ * Every connection has a thread that reads its requests. Solve requests go into one queue that a
+ * batcher thread drains in micro-batches: it waits up to batchWindow after the first request for
+ * up to maxBatch requests and solves them back to back with one BatchSolver, so a burst of small
+ * requests costs one wake-up instead of one per request.
+ */
+class SolverDaemon {
+public:
+    explicit SolverDaemon(const SolverDaemonOptions& options = {}) : options(options) {}
+    SolverDaemon(const SolverDaemon&) = delete;
+    SolverDaemon& operator=(const SolverDaemon&) = delete;
+
+    ~SolverDaemon() { stop(); }
+
+    /**
+     * @brief Listens on socketPath, replacing any stale socket there, and starts serving.
+     */
+    bool start(const string& socketPath) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) return false;
+        memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        listener = UniqueFd(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        unlink(socketPath.c_str());
+        if (listener.get() < 0 || bind(listener.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(listener.get(), 128) != 0) {
+            listener = UniqueFd();
+            return false;
+        }
+        path = socketPath;
+        started = chrono::steady_clock::now();
+        stopping = false;
+        batcher = thread([this] { runBatcher(); });
+        acceptor = thread([this] { runAcceptor(); });
+        return true;
+    }
+
+    /**
+     * @brief Stops accepting, answers the requests already queued and closes every connection.
+     */
+    void stop() {
+        if (!acceptor.joinable()) return;
+        {
+            lock_guard<mutex> lock(queueMutex);
+            stopping = true;
+        }
+        shutdown(listener.get(), SHUT_RDWR);
+        acceptor.join();
+        {
+            lock_guard<mutex> lock(connectionMutex);
+            for (auto& connection : connections) shutdown(connection->fd.get(), SHUT_RDWR);
+        }
+        arrived.notify_all();
+        batcher.join();
+        for (auto& connection : connections) connection->worker.join();
+        connections.clear();
+        listener = UniqueFd();
+        unlink(path.c_str());
+    }
+
+    DaemonStats stats() const {
+        DaemonStats current = {};
+        current.requests = answered.load();
+        current.batches = batches.load();
+        current.uptimeSeconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        current.requestsPerSecond = current.uptimeSeconds > 0 ? current.requests / current.uptimeSeconds : 0;
+        vector<double> recent;
+        {
+            lock_guard<mutex> lock(queueMutex);
+            current.queueDepth = queue.size();
+            current.maxQueueDepth = maxQueueDepth;
+            recent = latencies;
+        }
+        auto percentile = [&](double p) {
+            if (recent.empty()) return 0.0;
+            auto nth = recent.begin() + min(recent.size() - 1, (size_t)(p * recent.size()));
+            nth_element(recent.begin(), nth, recent.end());
+            return *nth;
+        };
+        current.p50Micros = percentile(0.50);
+        current.p90Micros = percentile(0.90);
+        current.p99Micros = percentile(0.99);
+        return current;
+    }
+
+private:
+    // Latencies kept for the percentiles
+    static const size_t LATENCY_SAMPLES = 4096;
+
+    struct Connection {
+        UniqueFd fd;
+        thread worker;
+        atomic<bool> done{false};
+    };
+
+    struct Request {
+        int n, root;
+        bool wantParents;
+        vector<Edge> inlineEdges;
+        MappedFile shared;
+        span<const Edge> edges;
+        chrono::steady_clock::time_point arrival;
+        promise<BatchResult> reply;
+    };
+
+    void runAcceptor() {
+        while (true) {
+            int fd = accept4(listener.get(), nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return;
+            }
+            lock_guard<mutex> lock(connectionMutex);
+            erase_if(connections, [](unique_ptr<Connection>& connection) {
+                if (!connection->done) return false;
+                connection->worker.join();
+                return true;
+            });
+            auto connection = make_unique<Connection>();
+            connection->fd = UniqueFd(fd);
+            Connection* served = connection.get();
+            connection->worker = thread([this, served] {
+                serve(served->fd.get());
+                shutdown(served->fd.get(), SHUT_RDWR);
+                served->done = true;
+            });
+            connections.push_back(move(connection));
+        }
+    }
+
+    void serve(int fd) {
+        DaemonRequest header;
+        int passedFd;
+        while (receiveAll(fd, &header, sizeof(header), &passedFd)) {
+            UniqueFd shared(passedFd);
+            if (header.magic != DAEMON_MAGIC) return;
+            if (header.type == DAEMON_STATS) {
+                DaemonStats current = stats();
+                if (!sendAll(fd, &current, sizeof(current))) return;
+                continue;
+            }
+            if (header.type != DAEMON_SOLVE || header.n > options.maxNodes) return;
+
+            auto request = make_unique<Request>();
+            request->n = header.n;
+            request->root = header.root;
+            request->wantParents = header.flags & DAEMON_WANT_PARENTS;
+            if (header.flags & DAEMON_SHARED_MEMORY) {
+                // without F_SEAL_SHRINK the memfd could be truncated under the mapping and fault the
+                // batcher; without F_SEAL_WRITE the client could rewrite edges after they are validated
+                const int required = F_SEAL_SHRINK | F_SEAL_WRITE;
+                int seals = shared.get() < 0 ? -1 : fcntl(shared.get(), F_GET_SEALS);
+                if (seals < 0 || (seals & required) != required || !request->shared.open(shared.get()) ||
+                    request->shared.size() / sizeof(Edge) < header.numEdges) {
+                    return;
+                }
+                request->edges = {reinterpret_cast<const Edge*>(request->shared.data()), (size_t)header.numEdges};
+            } else {
+                if (header.numEdges > options.maxInlineEdges) return;
+                request->inlineEdges.resize(header.numEdges);
+                if (!receiveAll(fd, request->inlineEdges.data(), header.numEdges * sizeof(Edge))) return;
+                request->edges = request->inlineEdges;
+            }
+            request->arrival = chrono::steady_clock::now();
+            future<BatchResult> pending = request->reply.get_future();
+            bool queued;
+            {
+                // once stopping is set the batcher may already have drained the queue and left
+                lock_guard<mutex> lock(queueMutex);
+                queued = !stopping;
+                if (queued) {
+                    queue.push_back(move(request));
+                    maxQueueDepth = max<uint64_t>(maxQueueDepth, queue.size());
+                }
+            }
+            BatchResult result;
+            if (queued) {
+                arrived.notify_one();
+                result = pending.get();
+            } else {
+                result.status = EdmondsStatus::Cancelled;
+            }
+            DaemonReply reply = {(int32_t)result.status, (int32_t)result.parent.size(),
+                                 result.status == EdmondsStatus::Ok ? (int64_t)result.total : 0};
+            vector<iovec> parts = {{&reply, sizeof(reply)}};
+            if (!result.parent.empty()) parts.push_back({result.parent.data(), result.parent.size() * sizeof(int)});
+            if (!writeGathered(fd, move(parts), true)) return;
+        }
+    }
+
+    void runBatcher() {
+        BatchSolver solver(options.engine, options.cache);
+        vector<unique_ptr<Request>> batch;
+        while (true) {
+            {
+                unique_lock<mutex> lock(queueMutex);
+                arrived.wait(lock, [&] { return stopping || !queue.empty(); });
+                if (queue.empty()) return;
+                arrived.wait_for(lock, options.batchWindow,
+                                 [&] { return stopping || queue.size() >= options.maxBatch; });
+                size_t take = min(queue.size(), options.maxBatch);
+                for (size_t r = 0; r < take; r++) batch.push_back(move(queue[r]));
+                queue.erase(queue.begin(), queue.begin() + take);
+            }
+            TraceSpan batchSpan("daemonBatch");
+            batchSpan.arg("requests", (long long)batch.size());
+            batches++;
+            for (unique_ptr<Request>& request : batch) {
+                BatchResult result;
+                try {
+                    solver.solve(request->n, request->root, request->edges, result);
+                } catch (const bad_alloc&) {
+                    result = {};
+                    result.status = EdmondsStatus::OutOfMemory;
+                }
+                if (!request->wantParents || result.status != EdmondsStatus::Ok) result.parent.clear();
+                double latency = chrono::duration<double, micro>(chrono::steady_clock::now() - request->arrival).count();
+                {
+                    // counted before the reply goes out, so a client always sees its own request in the stats
+                    lock_guard<mutex> lock(queueMutex);
+                    if (latencies.size() < LATENCY_SAMPLES) latencies.push_back(latency);
+                    else latencies[nextLatency] = latency;
+                    nextLatency = (nextLatency + 1) % LATENCY_SAMPLES;
+                }
+                answered++;
+                request->reply.set_value(move(result));
+            }
+            batch.clear();
+        }
+    }
+
+    SolverDaemonOptions options;
+    string path;
+    UniqueFd listener;
+    thread acceptor, batcher;
+    chrono::steady_clock::time_point started;
+
+    mutex connectionMutex;
+    vector<unique_ptr<Connection>> connections;
+
+    mutable mutex queueMutex;
+    condition_variable arrived;
+    deque<unique_ptr<Request>> queue;
+    bool stopping = false;
+    uint64_t maxQueueDepth = 0;
+    vector<double> latencies;
+    size_t nextLatency = 0;
+    atomic<uint64_t> answered{0}, batches{0};
+};
+
+/**
+ * @brief A connection to a SolverDaemon.
+ */
+class SolverClient {
+public:
+    /**
+     * @param sharedMemoryBytes Edge payloads at least this large are handed over in a memfd
+     *                          instead of being copied through the socket, sealed so that it can
+     *                          no longer change size or contents.
+     */
+    explicit SolverClient(size_t sharedMemoryBytes = 1 << 20) : sharedMemoryBytes(sharedMemoryBytes) {}
+
+    bool connect(const string& socketPath) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) return false;
+        memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        socketFd = UniqueFd(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        return socketFd.get() >= 0 &&
+               ::connect(socketFd.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    }
+
+    /**
+     * @brief Solves one graph on the daemon. result.parent is filled only if wantParents is set.
+     *
+     * @return false if the connection failed.
+     */
+    bool solve(int n, int root, span<const Edge> edges, BatchResult& result, bool wantParents = false) {
+        DaemonRequest header = {DAEMON_MAGIC, DAEMON_SOLVE, wantParents ? DAEMON_WANT_PARENTS : 0, n, root, 0,
+                                edges.size()};
+        size_t bytes = edges.size() * sizeof(Edge);
+        if (bytes >= sharedMemoryBytes) {
+            UniqueFd shared(memfd_create("edmonds-edges", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+            if (shared.get() < 0 || ftruncate(shared.get(), bytes) != 0 ||
+                pwrite(shared.get(), edges.data(), bytes, 0) != (ssize_t)bytes ||
+                fcntl(shared.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE) != 0) {
+                return false;
+            }
+            header.flags |= DAEMON_SHARED_MEMORY;
+            iovec part = {&header, sizeof(header)};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+            msghdr message = {};
+            message.msg_iov = &part;
+            message.msg_iovlen = 1;
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+            cmsghdr* rights = CMSG_FIRSTHDR(&message);
+            rights->cmsg_level = SOL_SOCKET;
+            rights->cmsg_type = SCM_RIGHTS;
+            rights->cmsg_len = CMSG_LEN(sizeof(int));
+            int descriptor = shared.get();
+            memcpy(CMSG_DATA(rights), &descriptor, sizeof(int));
+            if (sendmsg(socketFd.get(), &message, MSG_NOSIGNAL) != (ssize_t)sizeof(header)) return false;
+        } else if (!sendAll(socketFd.get(), &header, sizeof(header)) || !sendAll(socketFd.get(), edges.data(), bytes)) {
+            return false;
+        }
+        DaemonReply reply;
+        if (!receiveAll(socketFd.get(), &reply, sizeof(reply)) || reply.parentCount < 0) return false;
+        result.status = (EdmondsStatus)reply.status;
+        result.total = (int)reply.total;
+        result.parent.resize(reply.parentCount);
+        return receiveAll(socketFd.get(), result.parent.data(), result.parent.size() * sizeof(int));
+    }
+
+    bool stats(DaemonStats& stats) {
+        DaemonRequest header = {DAEMON_MAGIC, DAEMON_STATS, 0, 0, 0, 0, 0};
+        return sendAll(socketFd.get(), &header, sizeof(header)) && receiveAll(socketFd.get(), &stats, sizeof(stats));
+    }
+
+private:
+    size_t sharedMemoryBytes;
+    UniqueFd socketFd;
+};
+
+/**
+ * @brief Runs tasks posted to it, on threads of its own choosing.
+ */
+class Executor {
+public:
+    virtual ~Executor() = default;
+    virtual void post(function<void()> task) = 0;
+};
+
+/**
+ * @brief An Executor with a fixed pool of worker threads taking tasks in posting order.
+ * Destruction runs the tasks already posted, then joins the workers.
+ */
+class ThreadPoolExecutor : public Executor {
+public:
+    /**
+     * @param threads Number of workers; 0 means one per hardware thread.
+     */
+    explicit ThreadPoolExecutor(int threads = 0) {
+        int count = threads > 0 ? threads : max(1u, thread::hardware_concurrency());
+        for (int t = 0; t < count; t++) {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+
+    ~ThreadPoolExecutor() override {
+        {
+            lock_guard<mutex> lock(guard);
+            stopping = true;
+        }
+        posted.notify_all();
+        for (thread& worker : workers) worker.join();
+    }
+
+    void post(function<void()> task) override {
+        {
+            lock_guard<mutex> lock(guard);
+            tasks.push_back(move(task));
+        }
+        posted.notify_one();
+    }
+
+private:
+    void run() {
+        while (true) {
+            function<void()> task;
+            {
+                unique_lock<mutex> lock(guard);
+                posted.wait(lock, [&] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    mutex guard;
+    condition_variable posted;
+    deque<function<void()>> tasks;
+    bool stopping = false;
+    vector<thread> workers;
+};
+
+/**
+ * @brief Solves a graph on an executor and returns a future of the result.
+ *
+ * The edges are moved into the task, so the caller's copy may go away at once. result.status is
+ * Cancelled or TimedOut if stop fires before the solve completes.
+ */
+future<BatchResult> solveAsync(Executor& executor, int n, int root, vector<Edge> edges, SolveStop stop = {},
+                               BatchEngine engine = BatchEngine::Tarjan) {
+    auto promised = make_shared<promise<BatchResult>>();
+    future<BatchResult> result = promised->get_future();
+    executor.post([promised, n, root, edges = move(edges), stop = move(stop), engine] {
+        BatchResult solved;
+        BatchSolver(engine).solve(n, root, edges, solved, &stop);
+        promised->set_value(move(solved));
+    });
+    return result;
+}
+
+/**
+ * @brief co_await-able solve: suspends the awaiting coroutine, solves on the executor and resumes
+ * the coroutine on the executor thread with the BatchResult.
+ */
+class SolveAwaitable {
+public:
+    SolveAwaitable(Executor& executor, int n, int root, vector<Edge> edges, SolveStop stop,
+                   BatchEngine engine = BatchEngine::Tarjan)
+        : executor(executor), n(n), root(root), edges(move(edges)), stop(move(stop)), engine(engine) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(coroutine_handle<> awaiting) {
+        // the awaitable lives in the suspended coroutine's frame until it resumes
+        executor.post([this, awaiting] {
+            BatchSolver(engine).solve(n, root, edges, result, &stop);
+            awaiting.resume();
+        });
+    }
+
+    BatchResult await_resume() { return move(result); }
+
+private:
+    Executor& executor;
+    int n, root;
+    vector<Edge> edges;
+    SolveStop stop;
+    BatchEngine engine;
+    BatchResult result;
+};
+
+/**
+ * @brief Returns an awaitable that solves the graph on executor; see SolveAwaitable.
+ */
+SolveAwaitable solveAwaitable(Executor& executor, int n, int root, vector<Edge> edges, SolveStop stop,
+                              BatchEngine engine = BatchEngine::Tarjan) {
+    return SolveAwaitable(executor, n, root, move(edges), move(stop), engine);
+}
+
+/**
+ * @brief solveAwaitable without a stop condition.
+ *
+ * An overload rather than a default argument: GCC 12 destroys a class-type default argument
+ * twice when the call is the operand of co_await.
+ */
+SolveAwaitable solveAwaitable(Executor& executor, int n, int root, vector<Edge> edges) {
+    return SolveAwaitable(executor, n, root, move(edges), SolveStop());
+}
+
+#ifndef EDMONDS_NO_MAIN
+
+/**
+ * @brief Builds a random graph with n nodes and m edges (m >= n - 1) in which every node is reachable from node 0.
+ */
+vector<Edge> randomGraph(int n, int m, unsigned seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<int> node(0, n - 1), weight(1, 1000);
+    vector<Edge> edges;
+    edges.reserve(m);
+    for (int i = 1; i < n; i++) {
+        edges.push_back({(int)(rng() % i), i, weight(rng)});
+    }
+    while ((int)edges.size() < m) {
+        edges.push_back({node(rng), node(rng), weight(rng)});
+    }
+    return edges;
+}
+
+/**
+ * @brief Checks that parent describes an arborescence rooted at root, made of edges of the graph,
+ * whose total weight is total.
+ */
+bool isArborescence(int n, int root, span<const Edge> edges, span<const int> parent, long long total) {
+    if ((int)parent.size() != n || parent[root] != -1) return false;
+    vector<int> cheapest(n, INT_MAX);
+    vector<bool> found(n, false);
+    for (const Edge& edge : edges) {
+        if (edge.to != root && edge.from == parent[edge.to] && edge.from != edge.to) {
+            cheapest[edge.to] = min(cheapest[edge.to], edge.weight);
+            found[edge.to] = true;
+        }
+    }
+    long long sum = 0;
+    for (int v = 0; v < n; v++) {
+        if (v == root) continue;
+        if (!found[v]) return false;
+        sum += cheapest[v];
+        int steps = 0;
+        for (int u = v; u != root; u = parent[u]) {
+            if (u < 0 || ++steps > n) return false;
+        }
+    }
+    return sum == total;
+}
+
+void testChuLiuEdmonds() {
+    cout << "Running ChuLiuEdmonds Tests..." << endl;
+
+    // Test Case 1: Simple tree, no cycles
+    {
+        cout << "  Test Case 1: Simple Tree..." << flush;
+        int n = 3;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 5}};
+        int expected = 15;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected );
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Simple cycle
+    {
+        cout << "  Test Case 2: Simple Cycle..." << flush;
+        int n = 3;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 10}, {1, 2, 20}, {2, 1, 5}};
+        int expected = 30;
+        int result = chuLiuEdmonds(n, root, edges);
+         assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+     // Test Case 3: Unreachable node (no incoming edges)
+    {
+        cout << "  Test Case 3: Unreachable Node..." << flush;
+        int n = 3;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 10}};
+        int expected = -1;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: Root unreachable (from some node perspective)
+    {
+        cout << "  Test Case 4: Node with no incoming edge..." << flush;
+        int n = 3;
+        int root = 0;
+        vector<Edge> edges = {{1, 0, 10}, {1, 2, 5}};
+        int expected = -1;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+
+    // Test Case 5: More Complex Cycle
+    {
+        cout << "  Test Case 5: More Complex Cycle..." << flush;
+        int n = 4;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 10}, {1, 2, 10}, {2, 3, 10}, {3, 1, 10}, {0, 3, 30}};
+        int expected = 30;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 6: Disconnected Graph (nodes unreachable from root component)
+    {
+        cout << "  Test Case 6: Disconnected Graph..." << flush;
+        int n = 4;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 10}, {2, 3, 5}}; 
+        int expected = -1;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 7: Single Node
+    {
+        cout << "  Test Case 7: Single Node..." << flush;
+        int n = 1;
+        int root = 0;
+        vector<Edge> edges = {};
+        int expected = 0;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+     // Test Case 8: Two Nodes, Path Exists
+    {
+        cout << "  Test Case 8: Two Nodes Path..." << flush;
+        int n = 2;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 5}};
+        int expected = 5;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 9: Two Nodes, No Path
+    {
+        cout << "  Test Case 9: Two Nodes No Path..." << flush;
+        int n = 2;
+        int root = 0;
+        vector<Edge> edges = {};
+        int expected = -1;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 10: Negative Weights, No Cycle
+    {
+        cout << "  Test Case 10: Negative Weights No Cycle..." << flush;
+        int n = 3;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 10}, {1, 2, -5}, {0, 2, 8}};
+        int expected = 5;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+     // Test Case 11: Negative Weights with Cycle
+    {
+        cout << "  Test Case 11: Negative Weights Cycle..." << flush;
+        int n = 3;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 10}, {1, 2, 5}, {2, 1, -8}};
+        int expected = 15;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+     // Test Case 12: Alternative Path Chosen After Contraction
+    {
+        cout << "  Test Case 12: Alt Path Post-Contraction..." << flush;
+        int n = 4;
+        int root = 0;
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 12}, {1, 2, 5}, {2, 1, 3}, {0, 3, 20}};
+        vector<Edge> edges_copy = edges;
+        int expected = 35;
+        int result = chuLiuEdmonds(n, root, edges);
+        assert(result == expected );
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 13: Two Disjoint Cycles
+    {
+        cout << "  Test Case 13: Two Disjoint Cycles..." << flush;
+        int n = 5;
+        int root = 4;
+        vector<Edge> edges = {
+            {4, 0, 10}, {0, 1, 5}, {1, 0, 6},
+            {4, 2, 12}, {2, 3, 7}, {3, 2, 8},
+            {4, 1, 18}, {4, 3, 22}
+        };
+        vector<Edge> edges_copy = edges;
+        int expected = 34;
+        int result = chuLiuEdmonds(n, root, edges_copy);
+        assert(result == expected);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testChromeTrace() {
+    cout << "Running Chrome Trace Tests..." << endl;
+
+    // Test Case 1: Disabled tracer records nothing
+    {
+        cout << "  Test Case 1: Disabled By Default..." << flush;
+        clearChromeTrace();
+        vector<Edge> edges = {{0, 1, 10}, {1, 2, 20}, {2, 1, 5}};
+        chuLiuEdmonds(3, 0, edges);
+        ostringstream out;
+        writeChromeTrace(out);
+        assert(out.str().find("chuLiuEdmonds") == string::npos);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Solve, round and phase spans with annotations
+    {
+        cout << "  Test Case 2: Nested Spans..." << flush;
+        clearChromeTrace();
+        enableChromeTrace(true);
+        vector<Edge> edges = {{0, 1, 10}, {1, 2, 20}, {2, 1, 5}};
+        int result = chuLiuEdmonds(3, 0, edges);
+        enableChromeTrace(false);
+        assert(result == 30);
+        ostringstream out;
+        writeChromeTrace(out);
+        string json = out.str();
+        assert(json.rfind("{\"traceEvents\":[", 0) == 0);
+        assert(json.find("\"name\":\"chuLiuEdmonds\"") != string::npos);
+        assert(json.find("\"n\":3,\"E\":3,\"cycles\":1") != string::npos);
+        assert(json.find("\"name\":\"round\"") != string::npos);
+        assert(json.find("\"name\":\"selectMinInEdges\"") != string::npos);
+        assert(json.find("\"name\":\"detectCycles\"") != string::npos);
+        assert(json.find("\"name\":\"contract\"") != string::npos);
+        assert(json.find("\"ph\":\"X\"") != string::npos);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Each thread records into its own buffer
+    {
+        cout << "  Test Case 3: Per-Thread Buffers..." << flush;
+        clearChromeTrace();
+        enableChromeTrace(true);
+        thread worker([] {
+            vector<Edge> edges = {{0, 1, 10}, {0, 2, 5}};
+            chuLiuEdmonds(3, 0, edges);
+        });
+        worker.join();
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 5}};
+        chuLiuEdmonds(3, 0, edges);
+        enableChromeTrace(false);
+        ostringstream out;
+        writeChromeTrace(out);
+        string json = out.str();
+        vector<int> tids;
+        for (size_t pos = json.find("\"tid\":"); pos != string::npos; pos = json.find("\"tid\":", pos + 1)) {
+            tids.push_back(stoi(json.substr(pos + 6)));
+        }
+        sort(tids.begin(), tids.end());
+        tids.erase(unique(tids.begin(), tids.end()), tids.end());
+        assert(tids.size() == 2);
+        clearChromeTrace();
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testCountingMemoryResource() {
+    cout << "Running Counting Memory Resource Tests..." << endl;
+
+    // Test Case 1: Allocations of a solve are counted and all released
+    {
+        cout << "  Test Case 1: Counts A Solve..." << flush;
+        CountingMemoryResource counter;
+        vector<Edge> edges = {{0, 1, 10}, {1, 2, 20}, {2, 1, 5}};
+        int result = chuLiuEdmonds(3, 0, edges, &counter);
+        assert(result == 30);
+        assert(counter.allocations() > 0);
+        assert(counter.bytesAllocated() >= 3 * 3 * sizeof(int));
+        assert(counter.peakBytes() >= 3 * 3 * sizeof(int));
+        assert(counter.peakBytes() <= counter.bytesAllocated());
+        assert(counter.currentBytes() == 0);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Reset starts a fresh measurement
+    {
+        cout << "  Test Case 2: Reset..." << flush;
+        CountingMemoryResource counter;
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 5}};
+        chuLiuEdmonds(3, 0, edges, &counter);
+        counter.reset();
+        assert(counter.allocations() == 0);
+        assert(counter.bytesAllocated() == 0);
+        assert(counter.peakBytes() == 0);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testArenaSolve() {
+    cout << "Running Arena Solve Tests..." << endl;
+
+    // Test Case 1: Stack fast path gives the same result as the heap solve
+    {
+        cout << "  Test Case 1: Stack Fast Path..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 12}, {1, 2, 5}, {2, 1, 3}, {0, 3, 20}};
+        size_t bytesUsed = 0;
+        int result = chuLiuEdmondsInArena(4, 0, edges, &bytesUsed);
+        assert(result == chuLiuEdmonds(4, 0, edges));
+        assert(bytesUsed > 0 && bytesUsed <= chuLiuEdmondsScratchBytes(4, edges.size()));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: An arena pre-sized by chuLiuEdmondsScratchBytes never needs its upstream
+    {
+        cout << "  Test Case 2: Pre-Sized Arena..." << flush;
+        vector<Edge> edges = randomGraph(300, 3000, 7);
+        vector<byte> buffer(chuLiuEdmondsScratchBytes(300, edges.size()));
+        pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), pmr::null_memory_resource());
+        int result = chuLiuEdmondsInArena(300, 0, edges, arena);
+        assert(result == chuLiuEdmonds(300, 0, edges));
+        // The arena was released, so it can be reused for the next solve
+        assert(chuLiuEdmondsInArena(300, 0, edges, arena) == result);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Large graphs fall back to a heap arena
+    {
+        cout << "  Test Case 3: Heap Arena..." << flush;
+        vector<Edge> edges = randomGraph(2000, 10000, 11);
+        size_t bytesUsed = 0;
+        assert(chuLiuEdmondsInArena(2000, 0, edges, &bytesUsed) == chuLiuEdmonds(2000, 0, edges));
+        assert(bytesUsed > 16 * 1024);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testWorkspaceSolve() {
+    cout << "Running Workspace Solve Tests..." << endl;
+
+    // Test Case 1: Solve entirely in caller-provided stack buffers
+    {
+        cout << "  Test Case 1: Stack Workspace..." << flush;
+        const Edge edges[] = {{0, 1, 10}, {0, 2, 12}, {1, 2, 5}, {2, 1, 3}, {0, 3, 20}};
+        EdmondsWorkspaceSize size = requiredWorkspace(4, 5);
+        assert(size.nodeInts == 4 && size.scratchEdges == 10);
+        int inFrom[4], inWeight[4], cycle[4], visited[4], id[4];
+        Edge scratch[10];
+        int minWeight = 0;
+        EdmondsStatus status = chuLiuEdmonds(4, 0, edges, {inFrom, inWeight, cycle, visited, id, scratch}, minWeight);
+        assert(status == EdmondsStatus::Ok);
+        assert(minWeight == 35);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Undersized spans are rejected up front
+    {
+        cout << "  Test Case 2: Workspace Too Small..." << flush;
+        const Edge edges[] = {{0, 1, 10}, {1, 2, 20}, {2, 1, 5}};
+        int inFrom[3], inWeight[3], cycle[3], visited[3], id[2];
+        Edge scratch[6];
+        int minWeight = 0;
+        assert(chuLiuEdmonds(3, 0, edges, {inFrom, inWeight, cycle, visited, id, scratch}, minWeight) ==
+               EdmondsStatus::WorkspaceTooSmall);
+        int bigId[3];
+        assert(chuLiuEdmonds(3, 0, edges, {inFrom, inWeight, cycle, visited, bigId, span<Edge>(scratch, 5)}, minWeight) ==
+               EdmondsStatus::WorkspaceTooSmall);
+        assert(chuLiuEdmonds(3, 0, edges, {inFrom, inWeight, cycle, visited, bigId, scratch}, minWeight) == EdmondsStatus::Ok);
+        assert(minWeight == 30);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Invalid arguments and unreachable nodes get distinct statuses
+    {
+        cout << "  Test Case 3: Error Statuses..." << flush;
+        int inFrom[3], inWeight[3], cycle[3], visited[3], id[3];
+        Edge scratch[4];
+        EdmondsWorkspace workspace = {inFrom, inWeight, cycle, visited, id, scratch};
+        int minWeight = 0;
+        const Edge unreachable[] = {{0, 1, 10}, {0, 1, 4}};
+        assert(chuLiuEdmonds(3, 0, unreachable, workspace, minWeight) == EdmondsStatus::NoArborescence);
+        assert(chuLiuEdmonds(3, 3, unreachable, workspace, minWeight) == EdmondsStatus::InvalidArgument);
+        const Edge outOfRange[] = {{0, 1, 10}, {0, 3, 4}};
+        assert(chuLiuEdmonds(3, 0, outOfRange, workspace, minWeight) == EdmondsStatus::InvalidArgument);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testCAbi() {
+    cout << "Running C ABI Tests..." << endl;
+
+    // Test Case 1: Packed edges with a caller-provided workspace
+    {
+        cout << "  Test Case 1: Packed Edges..." << flush;
+        const edmonds_edge edges[] = {{0, 1, 10}, {0, 2, 12}, {1, 2, 5}, {2, 1, 3}, {0, 3, 20}};
+        vector<int32_t> workspace(edmonds_workspace_bytes(4, 5) / sizeof(int32_t));
+        int32_t total = 0;
+        assert(edmonds_abi_version() == EDMONDS_ABI_VERSION);
+        assert(edmonds_solve_edges(4, 0, edges, 5, workspace.data(), workspace.size() * sizeof(int32_t), &total,
+                                   nullptr) == EDMONDS_OK);
+        assert(total == 35);
+        vector<int32_t> parent(4, -2);
+        total = 0;
+        assert(edmonds_solve_edges(4, 0, edges, 5, nullptr, 0, &total, parent.data()) == EDMONDS_OK && total == 35);
+        vector<Edge> packed(reinterpret_cast<const Edge*>(edges), reinterpret_cast<const Edge*>(edges) + 5);
+        assert(isArborescence(4, 0, packed, vector<int>(parent.begin(), parent.end()), total));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Parallel arrays with a library-allocated workspace
+    {
+        cout << "  Test Case 2: Parallel Arrays..." << flush;
+        const int32_t from[] = {4, 0, 1, 4, 2, 3, 4, 4};
+        const int32_t to[] = {0, 1, 0, 2, 3, 2, 1, 3};
+        const int32_t weight[] = {10, 5, 6, 12, 7, 8, 18, 22};
+        int32_t total = 0;
+        assert(edmonds_solve_arrays(5, 4, from, to, weight, 8, nullptr, 0, &total, nullptr) == EDMONDS_OK);
+        assert(total == 34);
+        int32_t parent[5];
+        total = 0;
+        assert(edmonds_solve_arrays(5, 4, from, to, weight, 8, nullptr, 0, &total, parent) == EDMONDS_OK && total == 34);
+        const int32_t expected[] = {4, 0, 4, 2, -1};
+        assert(equal(parent, parent + 5, expected));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Error codes
+    {
+        cout << "  Test Case 3: Error Codes..." << flush;
+        const edmonds_edge edges[] = {{0, 1, 10}};
+        vector<int32_t> workspace(edmonds_workspace_bytes(3, 1) / sizeof(int32_t));
+        size_t bytes = workspace.size() * sizeof(int32_t);
+        int32_t total = 0;
+        assert(edmonds_solve_edges(3, 0, edges, 1, workspace.data(), bytes, &total, nullptr) == EDMONDS_NO_ARBORESCENCE);
+        assert(edmonds_solve_edges(3, 0, edges, 1, workspace.data(), bytes - 1, &total, nullptr) ==
+               EDMONDS_WORKSPACE_TOO_SMALL);
+        assert(edmonds_solve_edges(3, 5, edges, 1, workspace.data(), bytes, &total, nullptr) == EDMONDS_INVALID_ARGUMENT);
+        assert(edmonds_solve_edges(3, 0, nullptr, 1, nullptr, 0, &total, nullptr) == EDMONDS_INVALID_ARGUMENT);
+        assert(edmonds_solve_edges(3, 0, edges, 1, nullptr, 0, nullptr, nullptr) == EDMONDS_INVALID_ARGUMENT);
+        int32_t parent[3] = {7, 7, 7};
+        assert(edmonds_solve_edges(3, 0, edges, 1, nullptr, 0, &total, parent) == EDMONDS_NO_ARBORESCENCE);
+        assert(parent[0] == 7 && parent[1] == 7 && parent[2] == 7);
+        const edmonds_edge outOfRange[] = {{0, 3, 1}};
+        assert(edmonds_solve_edges(3, 0, outOfRange, 1, nullptr, 0, &total, parent) == EDMONDS_INVALID_ARGUMENT);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testGraphFile() {
+    cout << "Running Graph File Tests..." << endl;
+    string path = (filesystem::temp_directory_path() / "edmonds_test_graph.bin").string();
+
+    // Test Case 1: Round trip through a mapped file, solved in place
+    {
+        cout << "  Test Case 1: Mapped Round Trip..." << flush;
+        vector<Edge> edges = randomGraph(200, 2000, 3);
+        assert(writeGraphFile(path, 200, 0, edges));
+        MappedGraph graph;
+        assert(graph.open(path));
+        assert(graph.nodes() == 200 && graph.root() == 0 && graph.edges().size() == edges.size());
+        for (int v = 0; v < graph.nodes(); v++) {
+            for (const Edge& edge : graph.edgesInto(v)) {
+                assert(edge.to == v);
+            }
+        }
+        assert(chuLiuEdmonds(graph.nodes(), graph.root(), graph.edges()) == chuLiuEdmonds(200, 0, edges));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Text edge list conversion
+    {
+        cout << "  Test Case 2: Text Conversion..." << flush;
+        istringstream text("# from to weight\n0 1 10\n0 2 12\n1 2 5\n2 1 3\n0 3 20\n");
+        assert(convertTextEdgeList(text, 0, path));
+        MappedGraph graph;
+        assert(graph.open(path));
+        assert(graph.nodes() == 4 && graph.edges().size() == 5);
+        assert(chuLiuEdmonds(graph.nodes(), graph.root(), graph.edges()) == 35);
+        istringstream malformed("0 1 10\n0 x 3\n");
+        assert(!convertTextEdgeList(malformed, 0, path));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Truncated and foreign files are rejected
+    {
+        cout << "  Test Case 3: Invalid Files..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 5}};
+        assert(writeGraphFile(path, 3, 0, edges));
+        filesystem::resize_file(path, filesystem::file_size(path) - 1);
+        MappedGraph graph;
+        assert(!graph.open(path));
+        ofstream(path, ios::trunc) << "0 1 10\n0 2 5\n";
+        assert(!graph.open(path));
+        assert(!graph.open(path + ".missing"));
+        vector<Edge> outOfRange = {{0, 1, 10}, {0, 3, 5}};
+        assert(!writeGraphFile(path, 3, 0, outOfRange) && errno == EINVAL);
+        outOfRange = {{-1, 1, 10}};
+        assert(!writeGraphFile(path, 3, 0, outOfRange));
+        assert(!writeGraphFile(path, 3, 3, edges) && !writeGraphFile(path, 0, 0, {}));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: Corrupt bucket offsets and an edge count whose byte size wraps are rejected
+    {
+        cout << "  Test Case 4: Corrupt Offsets..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 5}};
+        auto patch = [&](size_t position, uint64_t value) {
+            fstream file(path, ios::binary | ios::in | ios::out);
+            file.seekp(position);
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+        MappedGraph graph;
+        int minWeight = 0;
+        assert(writeGraphFile(path, 3, 0, edges));
+        patch(sizeof(GraphFileHeader) + 2 * sizeof(uint64_t), 100);
+        assert(!graph.open(path));
+        assert(chuLiuEdmondsSemiExternal(path, minWeight) == EdmondsStatus::InvalidArgument);
+        assert(writeGraphFile(path, 3, 0, edges));
+        patch(sizeof(GraphFileHeader) + sizeof(uint64_t), 2);
+        assert(!graph.open(path));
+        assert(chuLiuEdmondsSemiExternal(path, minWeight) == EdmondsStatus::InvalidArgument);
+        // 12 * (2 + 2^62) wraps to the size of the two edges actually present.
+        uint64_t wrapped = 2 + (1ULL << 62);
+        assert(writeGraphFile(path, 3, 0, edges));
+        patch(offsetof(GraphFileHeader, numEdges), wrapped);
+        patch(sizeof(GraphFileHeader) + 3 * sizeof(uint64_t), wrapped);
+        assert(!graph.open(path));
+        assert(chuLiuEdmondsSemiExternal(path, minWeight) == EdmondsStatus::InvalidArgument);
+        assert(writeGraphFile(path, 3, 0, edges) && graph.open(path));
+        assert(chuLiuEdmondsSemiExternal(path, minWeight) == EdmondsStatus::Ok && minWeight == 15);
+        cout << " Passed." << endl;
+    }
+
+    filesystem::remove(path);
+    cout << "All test cases passed!" << endl;
+}
+
+void testNodeIdMap() {
+    cout << "Running Node Id Map Tests..." << endl;
+
+    // Test Case 1: Remap a hashed-id graph, solve it and translate the tree back
+    {
+        cout << "  Test Case 1: Remap And Translate..." << flush;
+        const uint64_t a = 0x9e3779b97f4a7c15ULL, b = 0xffffffffffffffffULL, c = 0, d = 1ULL << 40;
+        vector<uint64_t> from = {a, b, c, c, a};
+        vector<uint64_t> to = {b, c, b, d, d};
+        vector<int32_t> weight = {10, 5, 3, 7, 20};
+        NodeIdMap ids;
+        vector<Edge> edges = ids.remapEdges(from, to, weight);
+        assert(ids.size() == 4);
+        for (uint64_t id : {a, b, c, d}) {
+            assert(ids.find(id) >= 0 && ids.find(id) < 4 && ids.originalId(ids.find(id)) == id);
+        }
+        assert(ids.find(12345) == -1);
+        assert(edges[1].from == ids.find(b) && edges[1].to == ids.find(c) && edges[1].weight == 5);
+        assert(chuLiuEdmonds(ids.size(), ids.find(a), edges) == 22);
+
+        vector<int> parent(4, -1);
+        parent[ids.find(b)] = ids.find(a);
+        parent[ids.find(c)] = ids.find(b);
+        parent[ids.find(d)] = ids.find(c);
+        vector<pair<uint64_t, uint64_t>> tree = ids.originalArborescence(parent);
+        sort(tree.begin(), tree.end());
+        assert((tree == vector<pair<uint64_t, uint64_t>>{{c, b}, {d, c}, {b, a}}));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Dense ids do not depend on the number of build threads
+    {
+        cout << "  Test Case 2: Parallel Build..." << flush;
+        mt19937_64 rng(9);
+        vector<uint64_t> keys(200000);
+        for (uint64_t& key : keys) key = rng() % 50000 * 0x100000001ULL;
+        NodeIdMap sequential, parallel;
+        sequential.build(keys, 1);
+        parallel.build(keys, 5);
+        assert(sequential.size() == parallel.size());
+        for (uint64_t key : keys) {
+            int v = parallel.find(key);
+            assert(v == sequential.find(key) && parallel.originalId(v) == key);
+        }
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testEdgeListParser() {
+    cout << "Running Edge List Parser Tests..." << endl;
+
+    // Test Case 1: Whitespace triples with comments, split across threads
+    {
+        cout << "  Test Case 1: Triples..." << flush;
+        string text = "# from to weight\n0 1 10\n\n0 2 12\n% comment\n1 2 5\n  2\t1 3\r\n0 3 -20";
+        for (int threads : {1, 2, 4, 16}) {
+            ParsedEdgeList parsed;
+            assert(parseEdgeList(text, EdgeListFormat::Triples, parsed, false, threads));
+            assert(parsed.n == 4 && parsed.edges.size() == 5 && parsed.ids.size() == 0);
+            assert(parsed.edges[3].from == 2 && parsed.edges[3].to == 1 && parsed.edges[3].weight == 3);
+            assert(parsed.edges[4].weight == -20);
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: SNAP edge list with and without weights
+    {
+        cout << "  Test Case 2: SNAP..." << flush;
+        ParsedEdgeList parsed;
+        assert(parseEdgeList("# Nodes: 3 Edges: 3\n0\t1\n0\t2\t7\n2\t1\n", EdgeListFormat::Snap, parsed, false, 2));
+        assert(parsed.n == 3 && parsed.edges.size() == 3);
+        assert(parsed.edges[0].weight == 1 && parsed.edges[1].weight == 7);
+        assert(chuLiuEdmonds(parsed.n, 0, parsed.edges) == 8);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: DIMACS arcs are 1-based and the problem line sets n
+    {
+        cout << "  Test Case 3: DIMACS..." << flush;
+        ParsedEdgeList parsed;
+        assert(parseEdgeList("c sample\np sp 5 2\na 1 2 4\na 1 3 6\n", EdgeListFormat::Dimacs, parsed));
+        assert(parsed.n == 5 && parsed.edges.size() == 2);
+        assert(parsed.edges[1].from == 0 && parsed.edges[1].to == 2 && parsed.edges[1].weight == 6);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: Sparse 64-bit ids are remapped to dense ids
+    {
+        cout << "  Test Case 4: Id Remapping..." << flush;
+        string text = "1000000000000 -5 10\n1000000000000 42 12\n-5 42 5\n42 -5 3\n";
+        ParsedEdgeList parsed;
+        assert(!parseEdgeList(text, EdgeListFormat::Triples, parsed));
+        assert(parseEdgeList(text, EdgeListFormat::Triples, parsed, true, 3));
+        assert(parsed.n == 3);
+        int big = parsed.ids.find(1000000000000), minusFive = parsed.ids.find((uint64_t)-5);
+        assert(big >= 0 && minusFive >= 0 && parsed.ids.find(42) >= 0 && parsed.ids.find(7) == -1);
+        assert(parsed.edges[0].from == big && parsed.edges[0].to == minusFive);
+        assert(parsed.ids.originalId(big) == 1000000000000);
+        assert(chuLiuEdmonds(parsed.n, big, parsed.edges) == 15);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 5: Malformed lines fail the parse
+    {
+        cout << "  Test Case 5: Malformed Input..." << flush;
+        ParsedEdgeList parsed;
+        assert(!parseEdgeList("0 1 10\n0 1\n", EdgeListFormat::Triples, parsed));
+        assert(!parseEdgeList("0 1 10\n0 1 x\n", EdgeListFormat::Triples, parsed));
+        assert(!parseEdgeList("0 1 10 4\n", EdgeListFormat::Triples, parsed));
+        assert(!parseEdgeList("a 1 2\n", EdgeListFormat::Dimacs, parsed));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 6: Parallel and sequential parses agree on a large input
+    {
+        cout << "  Test Case 6: Parallel Agreement..." << flush;
+        vector<Edge> edges = randomGraph(5000, 50000, 5);
+        string text;
+        for (const Edge& edge : edges) {
+            text += to_string(edge.from) + ' ' + to_string(edge.to) + ' ' + to_string(edge.weight) + '\n';
+        }
+        ParsedEdgeList sequential, parallel;
+        assert(parseEdgeList(text, EdgeListFormat::Triples, sequential, false, 1));
+        assert(parseEdgeList(text, EdgeListFormat::Triples, parallel, false, 7));
+        assert(sequential.n == 5000 && parallel.n == 5000);
+        assert(sequential.edges.size() == edges.size() && parallel.edges.size() == edges.size());
+        for (size_t e = 0; e < edges.size(); e++) {
+            assert(parallel.edges[e].from == edges[e].from && parallel.edges[e].to == edges[e].to);
+            assert(parallel.edges[e].weight == edges[e].weight);
+        }
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testCompressedGraph() {
+    cout << "Running Compressed Graph Tests..." << endl;
+
+    auto sortedEdges = [](vector<Edge> edges) {
+        sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+            return tie(a.to, a.from, a.weight) < tie(b.to, b.from, b.weight);
+        });
+        return edges;
+    };
+
+    // Test Case 1: Decoding returns the input edges without self-loops, in a fraction of the space
+    {
+        cout << "  Test Case 1: Round Trip..." << flush;
+        vector<Edge> edges = randomGraph(5000, 100000, 17);
+        edges.push_back({3, 3, 1});
+        edges.push_back({0, 7, INT_MAX});
+        edges.push_back({1, 7, INT_MIN});
+        CompressedGraph graph(5000, edges);
+        vector<Edge> decoded;
+        graph.forEach([&](const Edge& edge) { decoded.push_back(edge); });
+        edges.erase(remove_if(edges.begin(), edges.end(), [](const Edge& edge) { return edge.from == edge.to; }),
+                    edges.end());
+        assert(graph.size() == edges.size());
+        vector<Edge> expected = sortedEdges(edges), actual = sortedEdges(decoded);
+        for (size_t e = 0; e < expected.size(); e++) {
+            assert(expected[e].from == actual[e].from && expected[e].to == actual[e].to);
+            assert(expected[e].weight == actual[e].weight);
+        }
+        assert(graph.bytes() * 3 < edges.size() * sizeof(Edge));
+        int from, weight;
+        assert(graph.minInEdge(7, from, weight) && from == 1 && weight == INT_MIN);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Compressed solves match the uncompressed solver
+    {
+        cout << "  Test Case 2: Solve Matches..." << flush;
+        vector<Edge> cycleEdges = {{0, 1, 10}, {0, 2, 12}, {1, 2, 5}, {2, 1, 3}, {0, 3, 20}};
+        int minWeight = 0;
+        assert(chuLiuEdmonds(4, 0, CompressedGraph(4, cycleEdges), minWeight) == EdmondsStatus::Ok && minWeight == 35);
+        for (unsigned seed = 1; seed <= 20; seed++) {
+            vector<Edge> edges = randomGraph(60, 400, seed);
+            for (Edge& edge : edges) edge.weight -= 500;
+            assert(chuLiuEdmonds(60, 0, CompressedGraph(60, edges), minWeight) == EdmondsStatus::Ok);
+            assert(minWeight == chuLiuEdmonds(60, 0, edges));
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Unreachable nodes and bad roots
+    {
+        cout << "  Test Case 3: Error Statuses..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {2, 3, 5}};
+        CompressedGraph graph(4, edges);
+        int minWeight = 0;
+        assert(chuLiuEdmonds(4, 0, graph, minWeight) == EdmondsStatus::NoArborescence);
+        assert(chuLiuEdmonds(4, 4, graph, minWeight) == EdmondsStatus::InvalidArgument);
+        assert(chuLiuEdmonds(5, 0, graph, minWeight) == EdmondsStatus::InvalidArgument);
+        vector<Edge> outOfRange = {{0, 1, 10}, {0, 4, 5}};
+        CompressedGraph rejected(4, outOfRange);
+        assert(!rejected.valid() && rejected.size() == 0);
+        assert(chuLiuEdmonds(4, 0, rejected, minWeight) == EdmondsStatus::InvalidArgument);
+        outOfRange = {{-1, 1, 10}};
+        assert(!CompressedGraph(4, outOfRange).valid() && !CompressedGraph(0, {}).valid());
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testSemiExternal() {
+    cout << "Running Semi-External Solver Tests..." << endl;
+    string path = (filesystem::temp_directory_path() / "edmonds_test_semi_external.bin").string();
+
+    // Test Case 1: Streaming solves match the in-memory solver, with records straddling small blocks
+    {
+        cout << "  Test Case 1: Solve Matches..." << flush;
+        SemiExternalOptions options;
+        options.blockBytes = IO_ALIGNMENT;
+        for (unsigned seed = 1; seed <= 10; seed++) {
+            vector<Edge> edges = randomGraph(200, 3000, seed);
+            for (Edge& edge : edges) edge.weight -= 500;
+            writeGraphFile(path, 200, 0, edges);
+            int minWeight = 0;
+            SemiExternalStats stats;
+            assert(chuLiuEdmondsSemiExternal(path, minWeight, options, &stats) == EdmondsStatus::Ok);
+            assert(minWeight == chuLiuEdmonds(200, 0, edges));
+            assert(stats.rounds >= 1 && stats.bytesRead >= edges.size() * sizeof(Edge));
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Direct I/O gives the same answer, whether or not the file system honours it
+    {
+        cout << "  Test Case 2: Direct I/O..." << flush;
+        vector<Edge> edges = randomGraph(1000, 20000, 7);
+        writeGraphFile(path, 1000, 0, edges);
+        SemiExternalOptions options;
+        options.directIo = true;
+        options.blockBytes = 3 * IO_ALIGNMENT;
+        int minWeight = 0;
+        assert(chuLiuEdmondsSemiExternal(path, minWeight, options) == EdmondsStatus::Ok);
+        assert(minWeight == chuLiuEdmonds(1000, 0, edges));
+
+        // A read resumed mid-block, as after a short read, restarts at an aligned offset
+        struct ResumableQueue : IoQueue {
+            using IoQueue::Request;
+            using IoQueue::finishSynchronously;
+        };
+        vector<uint8_t> contents(filesystem::file_size(path));
+        ifstream(path, ios::binary).read(reinterpret_cast<char*>(contents.data()), contents.size());
+        UniqueFd file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+        useDirectIo(file.get(), true);
+        IoBuffer block(3 * IO_ALIGNMENT);
+        ResumableQueue::Request request = {false, file.get(), block.data, block.size, IO_ALIGNMENT};
+        memcpy(block.data, contents.data() + IO_ALIGNMENT, 100);
+        assert(ResumableQueue::finishSynchronously(request, 100) == (ssize_t)block.size);
+        assert(memcmp(block.data, contents.data() + IO_ALIGNMENT, block.size) == 0);
+        // and stops at the end of the file
+        request.offset = (contents.size() / IO_ALIGNMENT - 1) * IO_ALIGNMENT;
+        size_t tail = contents.size() - request.offset;
+        memcpy(block.data, contents.data() + request.offset, 100);
+        assert(ResumableQueue::finishSynchronously(request, 100) == (ssize_t)tail);
+        assert(memcmp(block.data, contents.data() + request.offset, tail) == 0);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Unreachable nodes, missing files and bad temp directories
+    {
+        cout << "  Test Case 3: Error Statuses..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {2, 3, 5}};
+        writeGraphFile(path, 4, 0, edges);
+        int minWeight = 0;
+        assert(chuLiuEdmondsSemiExternal(path, minWeight) == EdmondsStatus::NoArborescence);
+        SemiExternalOptions options;
+        options.tempDirectory = "/nonexistent-edmonds-dir";
+        assert(chuLiuEdmondsSemiExternal(path, minWeight, options) == EdmondsStatus::IoError);
+        filesystem::remove(path);
+        assert(chuLiuEdmondsSemiExternal(path, minWeight) == EdmondsStatus::IoError);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: Streams written and read back through both backends at unaligned offsets
+    {
+        cout << "  Test Case 4: Async Backends..." << flush;
+        vector<Edge> edges = randomGraph(300, 5000, 3);
+        for (IoBackend backend : {IoBackend::IoUring, IoBackend::Threads}) {
+            string scratch = path + ".stream";
+            UniqueFd file(::open(scratch.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644));
+            assert(file.get() >= 0);
+            EdgeStreamWriter writer(file.get(), IO_ALIGNMENT, false, backend, 3);
+            for (const Edge& edge : edges) writer.append(edge);
+            assert(writer.finish() && writer.count() == edges.size());
+            assert(filesystem::file_size(scratch) == edges.size() * sizeof(Edge));
+            EdgeStreamReader reader(file.get(), 5 * sizeof(Edge), edges.size() - 5, IO_ALIGNMENT, false, backend, 3);
+            size_t e = 5;
+            assert(reader.forEach([&](const Edge& edge) {
+                assert(edge.from == edges[e].from && edge.to == edges[e].to && edge.weight == edges[e].weight);
+                e++;
+            }));
+            assert(e == edges.size());
+            filesystem::remove(scratch);
+
+            writeGraphFile(path, 300, 0, edges);
+            SemiExternalOptions options;
+            options.blockBytes = IO_ALIGNMENT;
+            options.ioBackend = backend;
+            int minWeight = 0;
+            SemiExternalStats stats;
+            assert(chuLiuEdmondsSemiExternal(path, minWeight, options, &stats) == EdmondsStatus::Ok);
+            assert(minWeight == chuLiuEdmonds(300, 0, edges));
+            if (backend == IoBackend::Threads) assert(stats.ioBackend == IoBackend::Threads);
+        }
+        filesystem::remove(path);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testTarjanSolve() {
+    cout << "Running Tarjan Solver Tests..." << endl;
+
+    // Test Case 1: Totals match the round-based solver and parents form the arborescence
+    {
+        cout << "  Test Case 1: Solve Matches..." << flush;
+        for (unsigned seed = 1; seed <= 40; seed++) {
+            int n = 2 + seed * 7;
+            vector<Edge> edges = randomGraph(n, n * (1 + seed % 6), seed);
+            for (Edge& edge : edges) edge.weight -= 500;
+            int minWeight = 0;
+            vector<int> parent;
+            assert(chuLiuEdmondsTarjan(n, 0, edges, minWeight, &parent) == EdmondsStatus::Ok);
+            assert(minWeight == chuLiuEdmonds(n, 0, edges));
+            assert(isArborescence(n, 0, edges, parent, minWeight));
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Nested cycles, parallel edges and self-loops
+    {
+        cout << "  Test Case 2: Nested Cycles..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 12}, {1, 2, 5}, {2, 1, 3}, {0, 3, 20}, {3, 3, 1},
+                              {2, 3, 4}, {3, 1, 1}, {1, 3, 9}, {1, 3, 2}};
+        int minWeight = 0;
+        vector<int> parent;
+        assert(chuLiuEdmondsTarjan(4, 0, edges, minWeight, &parent) == EdmondsStatus::Ok);
+        assert(minWeight == chuLiuEdmonds(4, 0, edges));
+        assert(isArborescence(4, 0, edges, parent, minWeight));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Unreachable nodes and bad arguments
+    {
+        cout << "  Test Case 3: Error Statuses..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {2, 3, 5}, {3, 2, 5}};
+        int minWeight = 0;
+        assert(chuLiuEdmondsTarjan(4, 0, edges, minWeight) == EdmondsStatus::NoArborescence);
+        assert(chuLiuEdmondsTarjan(4, 4, edges, minWeight) == EdmondsStatus::InvalidArgument);
+        assert(chuLiuEdmondsTarjan(3, 0, edges, minWeight) == EdmondsStatus::InvalidArgument);
+        assert(chuLiuEdmondsTarjan(1, 0, {}, minWeight) == EdmondsStatus::Ok && minWeight == 0);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testBatchPipeline() {
+    cout << "Running Batch Pipeline Tests..." << endl;
+    string path = (filesystem::temp_directory_path() / "edmonds_test_batch.bin").string();
+    vector<BatchGraph> graphs;
+    for (unsigned seed = 1; seed <= 30; seed++) {
+        int n = 10 + seed * 3;
+        graphs.push_back({seed - 1, n, (int)(seed % 3), randomGraph(n, n * 4, seed)});
+    }
+    graphs[7].edges = {{0, 1, 10}, {2, 3, 5}};
+    graphs[7].n = 4;
+    graphs[7].root = 0;
+    BatchFileWriter writer;
+    assert(writer.open(path));
+    for (const BatchGraph& graph : graphs) assert(writer.append(graph.n, graph.root, graph.edges));
+    assert(writer.close());
+
+    // Test Case 1: Graphs read back in order and unchanged
+    {
+        cout << "  Test Case 1: Round Trip..." << flush;
+        BatchFileReader reader;
+        assert(reader.open(path));
+        BatchGraph graph;
+        size_t count = 0;
+        while (reader.next(graph)) {
+            const BatchGraph& expected = graphs[count++];
+            assert(graph.index == expected.index && graph.n == expected.n && graph.root == expected.root);
+            assert(graph.edges.size() == expected.edges.size());
+            assert(memcmp(graph.edges.data(), expected.edges.data(), graph.edges.size() * sizeof(Edge)) == 0);
+        }
+        assert(!reader.failed() && count == graphs.size());
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Both engines deliver every result in order, with tiny queues too
+    {
+        cout << "  Test Case 2: Pipeline Results..." << flush;
+        for (BatchEngine engine : {BatchEngine::Tarjan, BatchEngine::ChuLiuEdmonds}) {
+            for (size_t capacity : {1, 8}) {
+                BatchPipelineOptions options;
+                options.engine = engine;
+                options.queueCapacity = capacity;
+                uint64_t next = 0;
+                assert(runBatchPipeline(path, [&](const BatchResult& result) {
+                    const BatchGraph& graph = graphs[next];
+                    assert(result.index == next++);
+                    int expected = chuLiuEdmonds(graph.n, graph.root, graph.edges);
+                    if (expected < 0) {
+                        assert(result.status == EdmondsStatus::NoArborescence);
+                        return;
+                    }
+                    assert(result.status == EdmondsStatus::Ok && result.total == expected);
+                    if (engine == BatchEngine::Tarjan) {
+                        assert(isArborescence(graph.n, graph.root, graph.edges, result.parent, expected));
+                    }
+                }, options));
+                assert(next == graphs.size());
+            }
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: A truncated file fails after delivering the complete graphs
+    {
+        cout << "  Test Case 3: Truncated File..." << flush;
+        filesystem::resize_file(path, filesystem::file_size(path) - 5);
+        uint64_t delivered = 0;
+        assert(!runBatchPipeline(path, [&](const BatchResult&) { delivered++; }));
+        assert(delivered == graphs.size() - 1);
+        filesystem::remove(path);
+        assert(!runBatchPipeline(path, [&](const BatchResult&) { delivered++; }));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: A graph claiming more nodes than the limit fails the batch before it is solved
+    {
+        cout << "  Test Case 4: Oversized Graph..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {1, 2, 5}};
+        assert(writer.open(path));
+        assert(writer.append(3, 0, edges) && writer.append(INT_MAX, 0, edges) && writer.append(3, 0, edges));
+        assert(writer.close());
+        uint64_t delivered = 0;
+        assert(!runBatchPipeline(path, [&](const BatchResult& result) {
+            assert(result.status == EdmondsStatus::Ok && result.total == 15);
+            delivered++;
+        }));
+        assert(delivered == 1);
+        assert(writer.open(path) && writer.append(40, 0, edges) && writer.close());
+        BatchPipelineOptions options;
+        options.maxNodes = 39;
+        assert(!runBatchPipeline(path, [&](const BatchResult&) { delivered++; }, options));
+        options.maxNodes = 40;
+        assert(runBatchPipeline(path, [&](const BatchResult& result) {
+            assert(result.status == EdmondsStatus::NoArborescence);
+            delivered++;
+        }, options));
+        assert(delivered == 2);
+        filesystem::remove(path);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testResultFile() {
+    cout << "Running Result File Tests..." << endl;
+    string path = (filesystem::temp_directory_path() / "edmonds_test_results.bin").string();
+
+    // Test Case 1: Records read back unchanged, across many small gathered writes
+    {
+        cout << "  Test Case 1: Round Trip..." << flush;
+        vector<BatchResult> results;
+        for (int r = 0; r < 3000; r++) {
+            BatchResult result;
+            result.index = r;
+            result.status = r % 7 == 3 ? EdmondsStatus::NoArborescence : EdmondsStatus::Ok;
+            result.total = r % 7 == 3 ? 0 : r * 1000 - 70000;
+            if (r % 7 != 3) {
+                for (int v = 0; v < r % 5; v++) result.parent.push_back(v - 1);
+            }
+            results.push_back(result);
+        }
+        ResultFileWriter writer(256);
+        assert(writer.open(path));
+        for (const BatchResult& result : results) writer.append(BatchResult(result));
+        assert(writer.close());
+
+        ResultFileReader reader;
+        assert(reader.open(path));
+        ResultView view;
+        size_t count = 0;
+        while (reader.next(view)) {
+            const BatchResult& expected = results[count++];
+            assert(view.index == expected.index && view.status == expected.status && view.total == expected.total);
+            assert(equal(view.parent.begin(), view.parent.end(), expected.parent.begin(), expected.parent.end()));
+            assert((uintptr_t)view.parent.data() % 8 == 0);
+        }
+        assert(!reader.failed() && count == results.size());
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: A batch solved straight to a result file
+    {
+        cout << "  Test Case 2: Solve Batch File..." << flush;
+        string batchPath = path + ".batch";
+        vector<vector<Edge>> graphs;
+        BatchFileWriter batch;
+        assert(batch.open(batchPath));
+        for (unsigned seed = 1; seed <= 10; seed++) {
+            graphs.push_back(randomGraph(50, 300, seed));
+            batch.append(50, 0, graphs.back());
+        }
+        assert(batch.close());
+        assert(solveBatchFile(batchPath, path));
+        ResultFileReader reader;
+        assert(reader.open(path));
+        ResultView view;
+        size_t count = 0;
+        while (reader.next(view)) {
+            const vector<Edge>& edges = graphs[count++];
+            assert(view.status == EdmondsStatus::Ok && view.total == chuLiuEdmonds(50, 0, edges));
+            assert(isArborescence(50, 0, edges, vector<int>(view.parent.begin(), view.parent.end()), view.total));
+        }
+        assert(count == graphs.size());
+        filesystem::remove(batchPath);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Truncated and foreign files are rejected
+    {
+        cout << "  Test Case 3: Malformed Files..." << flush;
+        filesystem::resize_file(path, filesystem::file_size(path) - 4);
+        ResultFileReader reader;
+        assert(reader.open(path));
+        ResultView view;
+        while (reader.next(view)) {}
+        assert(reader.failed());
+        ofstream(path) << "not a result file";
+        assert(!ResultFileReader().open(path));
+        filesystem::remove(path);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testSolverDaemon() {
+    cout << "Running Solver Daemon Tests..." << endl;
+    string socketPath = (filesystem::temp_directory_path() / "edmonds_test_daemon.sock").string();
+    SolverDaemonOptions options;
+    options.batchWindow = chrono::microseconds(2000);
+    SolverDaemon daemon(options);
+    assert(daemon.start(socketPath));
+
+    // Test Case 1: Concurrent clients get their own answers
+    {
+        cout << "  Test Case 1: Concurrent Clients..." << flush;
+        vector<thread> clients;
+        atomic<int> mismatches{0};
+        for (int c = 0; c < 4; c++) {
+            clients.emplace_back([&, c] {
+                SolverClient client;
+                if (!client.connect(socketPath)) {
+                    mismatches++;
+                    return;
+                }
+                for (unsigned r = 0; r < 50; r++) {
+                    int n = 5 + (c * 50 + r) % 40;
+                    vector<Edge> edges = randomGraph(n, n * 3, c * 50 + r);
+                    BatchResult result;
+                    bool wantParents = r % 2 == 0;
+                    if (!client.solve(n, 0, edges, result, wantParents) || result.status != EdmondsStatus::Ok ||
+                        result.total != chuLiuEdmonds(n, 0, edges) || result.parent.empty() == wantParents ||
+                        (wantParents && !isArborescence(n, 0, edges, result.parent, result.total))) {
+                        mismatches++;
+                    }
+                }
+            });
+        }
+        for (thread& client : clients) client.join();
+        assert(mismatches == 0);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Large payloads handed over in shared memory
+    {
+        cout << "  Test Case 2: Shared Memory..." << flush;
+        SolverClient client(0);
+        assert(client.connect(socketPath));
+        vector<Edge> edges = randomGraph(3000, 60000, 5);
+        BatchResult result;
+        assert(client.solve(3000, 0, edges, result, true) && result.status == EdmondsStatus::Ok);
+        assert(result.total == chuLiuEdmonds(3000, 0, edges));
+        assert(isArborescence(3000, 0, edges, result.parent, result.total));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Failed solves report their status; malformed requests close the connection
+    {
+        cout << "  Test Case 3: Error Statuses..." << flush;
+        SolverClient client;
+        assert(client.connect(socketPath));
+        vector<Edge> edges = {{0, 1, 10}, {2, 3, 5}};
+        BatchResult result;
+        assert(client.solve(4, 0, edges, result, true) && result.status == EdmondsStatus::NoArborescence);
+        assert(result.parent.empty());
+        assert(client.solve(4, 7, edges, result) && result.status == EdmondsStatus::InvalidArgument);
+        // sends one request header, with descriptor attached if it is not -1, and checks that the
+        // daemon hangs up instead of answering
+        auto rejected = [&](DaemonRequest header, int descriptor) {
+            UniqueFd raw(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+            if (connect(raw.get(), reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) return false;
+            iovec part = {&header, sizeof(header)};
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+            msghdr message = {};
+            message.msg_iov = &part;
+            message.msg_iovlen = 1;
+            if (descriptor >= 0) {
+                message.msg_control = control;
+                message.msg_controllen = sizeof(control);
+                cmsghdr* rights = CMSG_FIRSTHDR(&message);
+                rights->cmsg_level = SOL_SOCKET;
+                rights->cmsg_type = SCM_RIGHTS;
+                rights->cmsg_len = CMSG_LEN(sizeof(int));
+                memcpy(CMSG_DATA(rights), &descriptor, sizeof(int));
+            }
+            if (sendmsg(raw.get(), &message, MSG_NOSIGNAL) != (ssize_t)sizeof(header)) return false;
+            char byte;
+            return recv(raw.get(), &byte, 1, 0) == 0;
+        };
+        assert(rejected({0, DAEMON_SOLVE, 0, 1, 0, 0, 0}, -1));
+        assert(rejected({DAEMON_MAGIC, DAEMON_SOLVE, 0, INT_MAX, 0, 0, 0}, -1));
+        // a memfd the client could still shrink under the daemon's mapping
+        UniqueFd unsealed(memfd_create("edmonds-test", MFD_CLOEXEC));
+        assert(ftruncate(unsealed.get(), edges.size() * sizeof(Edge)) == 0);
+        assert(pwrite(unsealed.get(), edges.data(), edges.size() * sizeof(Edge), 0) == (ssize_t)(edges.size() * sizeof(Edge)));
+        assert(rejected({DAEMON_MAGIC, DAEMON_SOLVE, DAEMON_SHARED_MEMORY, 4, 0, 0, edges.size()}, unsealed.get()));
+        // a memfd sealed against shrinking whose edges the client could still rewrite after validation
+        UniqueFd writable(memfd_create("edmonds-test", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+        assert(ftruncate(writable.get(), edges.size() * sizeof(Edge)) == 0);
+        assert(pwrite(writable.get(), edges.data(), edges.size() * sizeof(Edge), 0) == (ssize_t)(edges.size() * sizeof(Edge)));
+        assert(fcntl(writable.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) == 0);
+        assert(rejected({DAEMON_MAGIC, DAEMON_SOLVE, DAEMON_SHARED_MEMORY, 4, 0, 0, edges.size()}, writable.get()));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: The stats endpoint counts requests, batches and latencies
+    {
+        cout << "  Test Case 4: Stats..." << flush;
+        SolverClient client;
+        assert(client.connect(socketPath));
+        DaemonStats stats;
+        assert(client.stats(stats));
+        assert(stats.requests == 203 && stats.batches >= 1 && stats.batches <= stats.requests);
+        assert(stats.queueDepth == 0 && stats.maxQueueDepth >= 1);
+        assert(stats.p50Micros > 0 && stats.p50Micros <= stats.p90Micros && stats.p90Micros <= stats.p99Micros);
+        assert(stats.requestsPerSecond > 0);
+        cout << " Passed." << endl;
+    }
+
+    daemon.stop();
+    assert(!filesystem::exists(socketPath));
+
+    // Test Case 5: Stopping while clients keep sending answers or drops every request, never hangs
+    {
+        cout << "  Test Case 5: Stop Under Load..." << flush;
+        for (int attempt = 0; attempt < 20; attempt++) {
+            SolverDaemon busy(options);
+            assert(busy.start(socketPath));
+            atomic<int> wrong{0};
+            vector<thread> clients;
+            for (int c = 0; c < 4; c++) {
+                clients.emplace_back([&, c] {
+                    SolverClient client;
+                    if (!client.connect(socketPath)) return;
+                    vector<Edge> edges = randomGraph(20, 60, c);
+                    BatchResult result;
+                    while (client.solve(20, 0, edges, result)) {
+                        if (result.status == EdmondsStatus::Ok ? result.total != chuLiuEdmonds(20, 0, edges)
+                                                               : result.status != EdmondsStatus::Cancelled) {
+                            wrong++;
+                        }
+                    }
+                });
+            }
+            this_thread::sleep_for(chrono::microseconds(500 * attempt));
+            busy.stop();
+            for (thread& client : clients) client.join();
+            assert(wrong == 0);
+        }
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testResultCache() {
+    cout << "Running Result Cache Tests..." << endl;
+
+    // Test Case 1: The hash ignores edge order but not n, root, endpoints or weights
+    {
+        cout << "  Test Case 1: Graph Hash..." << flush;
+        vector<Edge> edges = randomGraph(100, 1000, 1);
+        GraphHash hash = hashGraph(100, 0, edges);
+        vector<Edge> shuffled = edges;
+        shuffle(shuffled.begin(), shuffled.end(), mt19937(2));
+        assert(hashGraph(100, 0, shuffled) == hash);
+        assert(!(hashGraph(101, 0, edges) == hash) && !(hashGraph(100, 1, edges) == hash));
+        vector<Edge> changed = edges;
+        changed[500].weight++;
+        assert(!(hashGraph(100, 0, changed) == hash));
+        changed = edges;
+        swap(changed[500].from, changed[500].to);
+        assert(!(hashGraph(100, 0, changed) == hash));
+        changed.pop_back();
+        assert(!(hashGraph(100, 0, changed) == hash));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Repeated graphs are answered from the cache with identical results
+    {
+        cout << "  Test Case 2: Cached Solves..." << flush;
+        ResultCache cache;
+        BatchSolver solver(BatchEngine::Tarjan, &cache);
+        for (int pass = 0; pass < 2; pass++) {
+            for (unsigned seed = 1; seed <= 10; seed++) {
+                vector<Edge> edges = randomGraph(80, 400, seed);
+                BatchResult result;
+                solver.solve(80, 0, edges, result);
+                assert(result.status == EdmondsStatus::Ok && result.total == chuLiuEdmonds(80, 0, edges));
+                assert(isArborescence(80, 0, edges, result.parent, result.total));
+            }
+        }
+        vector<Edge> unreachable = {{0, 1, 10}, {2, 3, 5}};
+        BatchResult result;
+        solver.solve(4, 0, unreachable, result);
+        solver.solve(4, 0, unreachable, result);
+        assert(result.status == EdmondsStatus::NoArborescence);
+        assert(cache.hits() == 11 && cache.misses() == 11);
+
+        BatchSolver totalsOnly(BatchEngine::ChuLiuEdmonds, &cache);
+        vector<Edge> edges = randomGraph(80, 400, 99);
+        totalsOnly.solve(80, 0, edges, result);
+        solver.solve(80, 0, edges, result);
+        assert(isArborescence(80, 0, edges, result.parent, result.total));
+        assert(cache.hits() == 11 && cache.misses() == 13);
+        totalsOnly.solve(80, 0, edges, result);
+        solver.solve(80, 0, edges, result);
+        assert(isArborescence(80, 0, edges, result.parent, result.total));
+        assert(cache.hits() == 13 && cache.misses() == 13);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Memory stays within the budget, evicting least recently used entries first
+    {
+        cout << "  Test Case 3: Eviction..." << flush;
+        ResultCache cache(16 * 1024, 1);
+        BatchResult result;
+        result.parent.assign(100, 0);
+        for (uint64_t key = 0; key < 100; key++) cache.insert({key, key}, result);
+        assert(cache.bytes() <= 16 * 1024 && cache.evictions() > 0);
+        assert(cache.lookup({99, 99}, result) && !cache.lookup({0, 0}, result));
+        uint64_t oldest = 100 - 16 * 1024 / (128 + 400);
+        assert(cache.lookup({oldest, oldest}, result));
+        cache.insert({100, 100}, result);
+        assert(cache.lookup({oldest, oldest}, result) && !cache.lookup({oldest + 1, oldest + 1}, result));
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: Concurrent workers share one cache
+    {
+        cout << "  Test Case 4: Concurrent Workers..." << flush;
+        ResultCache cache(1 << 20);
+        vector<vector<Edge>> graphs;
+        for (unsigned seed = 1; seed <= 20; seed++) graphs.push_back(randomGraph(60, 300, seed));
+        atomic<int> mismatches{0};
+        vector<thread> workers;
+        for (int w = 0; w < 4; w++) {
+            workers.emplace_back([&, w] {
+                BatchSolver solver(BatchEngine::Tarjan, &cache);
+                for (int r = 0; r < 200; r++) {
+                    const vector<Edge>& edges = graphs[(r * 7 + w) % graphs.size()];
+                    BatchResult result;
+                    solver.solve(60, 0, edges, result);
+                    if (result.total != chuLiuEdmonds(60, 0, edges)) mismatches++;
+                }
+            });
+        }
+        for (thread& worker : workers) worker.join();
+        assert(mismatches == 0 && cache.hits() + cache.misses() == 800 && cache.misses() >= 20);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+/**
+ * @brief Minimal eagerly started, fire-and-forget coroutine type for the async solve tests.
+ */
+struct DetachedCoroutine {
+    struct promise_type {
+        DetachedCoroutine get_return_object() { return {}; }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+};
+
+DetachedCoroutine awaitSolve(Executor& executor, int n, vector<Edge> edges,
+                             promise<pair<BatchResult, thread::id>>& done) {
+    BatchResult result = co_await solveAwaitable(executor, n, 0, move(edges));
+    done.set_value({move(result), this_thread::get_id()});
+}
+
+void testAsyncSolve() {
+    cout << "Running Async Solve Tests..." << endl;
+    ThreadPoolExecutor executor(2);
+
+    // Test Case 1: Futures resolve to the same results as synchronous solves
+    {
+        cout << "  Test Case 1: Futures..." << flush;
+        vector<future<BatchResult>> pending;
+        vector<vector<Edge>> graphs;
+        for (unsigned seed = 1; seed <= 8; seed++) {
+            graphs.push_back(randomGraph(200, 2000, seed));
+            BatchEngine engine = seed % 2 ? BatchEngine::Tarjan : BatchEngine::ChuLiuEdmonds;
+            pending.push_back(solveAsync(executor, 200, 0, graphs.back(), {}, engine));
+        }
+        for (size_t g = 0; g < pending.size(); g++) {
+            BatchResult result = pending[g].get();
+            assert(result.status == EdmondsStatus::Ok && result.total == chuLiuEdmonds(200, 0, graphs[g]));
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: A coroutine resumes on the executor with the result
+    {
+        cout << "  Test Case 2: Coroutine..." << flush;
+        vector<Edge> edges = randomGraph(300, 3000, 4);
+        promise<pair<BatchResult, thread::id>> done;
+        future<pair<BatchResult, thread::id>> finished = done.get_future();
+        awaitSolve(executor, 300, edges, done);
+        auto [result, resumedOn] = finished.get();
+        assert(result.status == EdmondsStatus::Ok && result.total == chuLiuEdmonds(300, 0, edges));
+        assert(isArborescence(300, 0, edges, result.parent, result.total));
+        assert(resumedOn != this_thread::get_id());
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Cancelling a long solve stops it with Cancelled
+    {
+        cout << "  Test Case 3: Cancellation..." << flush;
+        vector<Edge> edges = randomGraph(20000, 400000, 8);
+        SolveStop stop;
+        future<BatchResult> pending = solveAsync(executor, 20000, 0, edges, stop, BatchEngine::ChuLiuEdmonds);
+        this_thread::sleep_for(chrono::milliseconds(10));
+        stop.token.cancel();
+        assert(pending.get().status == EdmondsStatus::Cancelled);
+        int minWeight = 0;
+        vector<int> parent;
+        assert(chuLiuEdmondsTarjan(20000, 0, edges, minWeight, &parent, &stop) == EdmondsStatus::Cancelled);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: A passed deadline stops the solve with TimedOut
+    {
+        cout << "  Test Case 4: Deadline..." << flush;
+        vector<Edge> edges = randomGraph(20000, 400000, 8);
+        SolveStop stop;
+        stop.deadline = chrono::steady_clock::now() + chrono::milliseconds(10);
+        future<BatchResult> pending = solveAsync(executor, 20000, 0, edges, stop, BatchEngine::ChuLiuEdmonds);
+        assert(pending.get().status == EdmondsStatus::TimedOut);
+        assert(solveAsync(executor, 20000, 0, edges, stop).get().status == EdmondsStatus::TimedOut);
+        SolveStop generous;
+        generous.deadline = chrono::steady_clock::now() + chrono::hours(1);
+        assert(solveAsync(executor, 20000, 0, edges, generous).get().status == EdmondsStatus::Ok);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testDynamicArborescence() {
+    cout << "Running Dynamic Arborescence Tests..." << endl;
+
+    // Test Case 1: The duals certify the arborescence
+    {
+        cout << "  Test Case 1: Dual Certificate..." << flush;
+        for (unsigned seed = 1; seed <= 30; seed++) {
+            int n = 2 + seed * 5;
+            vector<Edge> edges = randomGraph(n, n * (1 + seed % 5), seed);
+            for (Edge& edge : edges) edge.weight -= 500;
+            int minWeight = 0;
+            ArborescenceDuals duals;
+            assert(chuLiuEdmondsTarjan(n, 0, edges, minWeight, nullptr, nullptr, &duals) == EdmondsStatus::Ok);
+            long long sum = 0;
+            for (size_t s = 0; s < duals.dual.size(); s++) {
+                sum += duals.dual[s];
+                assert(s < (size_t)n || duals.dual[s] >= 0);
+            }
+            assert(sum == minWeight);
+            for (size_t e = 0; e < edges.size(); e++) {
+                const Edge& edge = edges[e];
+                if (edge.from == edge.to || edge.to == 0) continue;
+                long long reduced = edge.weight - duals.enteredDual(edge.from, edge.to);
+                assert(reduced >= 0);
+                assert(duals.inEdge[edge.to] != (int)e || reduced == 0);
+            }
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Insertions and decreases match a fresh solve
+    {
+        cout << "  Test Case 2: Updates Match..." << flush;
+        for (unsigned seed = 1; seed <= 10; seed++) {
+            int n = 30 + seed * 10;
+            DynamicArborescence dynamic(n, 0, randomGraph(n, n * 4, seed));
+            mt19937 rng(seed);
+            for (int update = 0; update < 200; update++) {
+                if (rng() % 2) {
+                    assert(dynamic.addEdge(rng() % n, rng() % n, 1 + rng() % 1500) >= 0);
+                } else {
+                    int index = rng() % dynamic.edgeList().size();
+                    int weight = dynamic.edgeList()[index].weight;
+                    assert(dynamic.decreaseWeight(index, weight - (int)(rng() % 300)));
+                }
+                int minWeight = 0;
+                assert(chuLiuEdmondsTarjan(n, 0, dynamic.edgeList(), minWeight) == EdmondsStatus::Ok);
+                assert(dynamic.status() == EdmondsStatus::Ok && dynamic.minWeight() == minWeight);
+                assert(isArborescence(n, 0, dynamic.edgeList(), dynamic.parents(), minWeight));
+            }
+            assert(dynamic.fastUpdateCount() > 0);
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 3: Removals and increases match a fresh solve, mostly without solving everything
+    {
+        cout << "  Test Case 3: Removals and Increases..." << flush;
+        size_t local = 0;
+        for (unsigned seed = 1; seed <= 10; seed++) {
+            int n = 20 + seed * 10;
+            vector<Edge> initial = randomGraph(n, n * 6, seed);
+            for (Edge& edge : initial) edge.weight -= 200;
+            DynamicArborescence dynamic(n, 0, initial);
+            mt19937 rng(seed);
+            for (int update = 0; update < 300; update++) {
+                int index = rng() % dynamic.edgeList().size();
+                int weight = dynamic.edgeList()[index].weight;
+                switch (rng() % 4) {
+                    case 0: dynamic.addEdge(rng() % n, rng() % n, (int)(rng() % 1000) - 200); break;
+                    case 1: {
+                        bool wasRemoved = dynamic.isRemoved(index);
+                        assert(dynamic.removeEdge(index) == !wasRemoved);
+                        break;
+                    }
+                    case 2: assert(dynamic.increaseWeight(index, weight + rng() % 500) == !dynamic.isRemoved(index)); break;
+                    default: assert(dynamic.decreaseWeight(index, weight - rng() % 500) == !dynamic.isRemoved(index)); break;
+                }
+                // some seeds let updates pile up between queries
+                if (update % (1 + seed % 3) != 0) continue;
+                vector<Edge> live;
+                for (size_t e = 0; e < dynamic.edgeList().size(); e++) {
+                    if (!dynamic.isRemoved(e)) live.push_back(dynamic.edgeList()[e]);
+                }
+                int minWeight = 0;
+                EdmondsStatus status = chuLiuEdmondsTarjan(n, 0, live, minWeight);
+                assert(dynamic.status() == status);
+                if (status != EdmondsStatus::Ok) break;
+                assert(dynamic.minWeight() == minWeight);
+                assert(isArborescence(n, 0, live, dynamic.parents(), minWeight));
+            }
+            local += dynamic.localResolveCount();
+        }
+        assert(local > 0);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 4: An insertion reaching an unreachable node, and rejected updates
+    {
+        cout << "  Test Case 4: Reachability..." << flush;
+        DynamicArborescence dynamic(3, 0, {{0, 1, 5}, {2, 1, 1}});
+        assert(dynamic.status() == EdmondsStatus::NoArborescence);
+        assert(dynamic.decreaseWeight(0, 2));
+        int index = dynamic.addEdge(1, 2, 4);
+        assert(index == 2);
+        assert(dynamic.status() == EdmondsStatus::Ok && dynamic.minWeight() == 6);
+        assert(dynamic.parents() == vector<int>({-1, 0, 1}));
+        assert(dynamic.addEdge(0, 3, 1) == -1);
+        assert(!dynamic.decreaseWeight(2, 5) && !dynamic.decreaseWeight(3, 0));
+        assert(dynamic.decreaseWeight(index, 1) && dynamic.minWeight() == 3);
+        assert(!dynamic.increaseWeight(index, 0) && dynamic.increaseWeight(index, 8));
+        assert(dynamic.minWeight() == 10);
+        assert(dynamic.removeEdge(index) && !dynamic.removeEdge(index) && !dynamic.increaseWeight(index, 9));
+        assert(dynamic.status() == EdmondsStatus::NoArborescence);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testWarmStart() {
+    cout << "Running Warm Start Tests..." << endl;
+
+    // Test Case 1: Drifting weights give the cold results, mostly from the old hierarchy
+    {
+        cout << "  Test Case 1: Drifting Weights..." << flush;
+        size_t reusedCount = 0, solves = 0;
+        for (unsigned seed = 1; seed <= 20; seed++) {
+            int n = 10 + seed * 15;
+            vector<Edge> edges = randomGraph(n, n * (2 + seed % 6), seed);
+            if (seed % 2) {
+                for (Edge& edge : edges) edge.weight = edge.weight % 20 - 5;
+            }
+            mt19937 rng(seed);
+            WarmStart warm;
+            for (int step = 0; step < 30; step++) {
+                int minWeight = 0;
+                bool reused = false;
+                assert(chuLiuEdmondsWarm(n, 0, edges, warm, minWeight, &reused) == EdmondsStatus::Ok);
+                assert(minWeight == chuLiuEdmonds(n, 0, edges));
+                assert(isArborescence(n, 0, edges, warm.parent, minWeight));
+                reusedCount += reused;
+                solves++;
+                for (int change = 0; change < 1 + (int)(seed % 3); change++) {
+                    edges[rng() % edges.size()].weight += (int)(rng() % 11) - 5;
+                }
+            }
+        }
+        assert(reusedCount > solves / 2);
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: A changed graph falls back to a cold solve
+    {
+        cout << "  Test Case 2: Fallback..." << flush;
+        vector<Edge> edges = {{0, 1, 10}, {0, 2, 12}, {1, 2, 5}, {2, 1, 3}, {2, 3, 4}, {3, 1, 1}};
+        WarmStart warm;
+        int minWeight = 0;
+        bool reused = true;
+        assert(chuLiuEdmondsWarm(4, 0, edges, warm, minWeight, &reused) == EdmondsStatus::Ok && !reused);
+        assert(minWeight == 17);
+        assert(chuLiuEdmondsWarm(4, 0, edges, warm, minWeight, &reused) == EdmondsStatus::Ok && reused);
+        assert(minWeight == 17);
+        edges[0].weight = 1;
+        assert(chuLiuEdmondsWarm(4, 0, edges, warm, minWeight, &reused) == EdmondsStatus::Ok);
+        assert(minWeight == chuLiuEdmonds(4, 0, edges) && isArborescence(4, 0, edges, warm.parent, minWeight));
+        edges.pop_back();
+        edges.pop_back();
+        assert(chuLiuEdmondsWarm(4, 0, edges, warm, minWeight, &reused) == EdmondsStatus::NoArborescence && !reused);
+        assert(warm.parent.empty());
+        assert(chuLiuEdmondsWarm(5, 0, edges, warm, minWeight) == EdmondsStatus::NoArborescence);
+        cout << " Passed." << endl;
+    }
+
+    cout << "All test cases passed!" << endl;
+}
+
+void testEdgeConstraints() {
+    cout << "Running Edge Constraints Tests..." << endl;
+
+    // Test Case 1: Masked solves match solves over a filtered copy of the graph
+    {
+        cout << "  Test Case 1: Filtered Copies..." << flush;
+        for (unsigned seed = 1; seed <= 200; seed++) {
+            int n = 2 + seed % 30;
+            vector<Edge> edges = randomGraph(n, n * (1 + seed % 5), seed);
+            mt19937 rng(seed);
+            EdgeConstraints constraints(n, edges.size());
+            vector<int> forcedInto(n, 0);
+            for (size_t e = 0; e < edges.size(); e++) {
+                if (rng() % 5 == 0) constraints.forbid(e);
+                if (rng() % (seed % 2 ? 8 : 40) == 0) {
+                    constraints.force(edges, e);
+                    forcedInto[edges[e].to]++;
+                }
+            }
+            vector<Edge> filtered;
+            for (size_t e = 0; e < edges.size(); e++) {
+                if (!constraints.forbidden(e) && (!forcedInto[edges[e].to] || constraints.forced(e))) {
+                    filtered.push_back(edges[e]);
+                }
+            }
+            bool conflict = forcedInto[0] > 0;
+            for (int v = 0; v < n; v++) conflict |= forcedInto[v] > 1;
+            for (size_t e = 0; e < edges.size(); e++) conflict |= constraints.forced(e) && constraints.forbidden(e);
+            int expected = conflict ? -1 : chuLiuEdmonds(n, 0, filtered);
+
+            assert(chuLiuEdmonds(n, 0, edges, constraints) == expected);
+            int minWeight = 0;
+            vector<int> parent;
+            EdmondsStatus status = chuLiuEdmondsTarjan(n, 0, edges, minWeight, &parent, nullptr, nullptr, &constraints);
+            assert(status == (expected < 0 ? EdmondsStatus::NoArborescence : EdmondsStatus::Ok));
+            if (expected < 0) continue;
+            assert(minWeight == expected);
+            for (size_t e = 0; e < edges.size(); e++) {
+                if (constraints.forced(e)) assert(parent[edges[e].to] == edges[e].from);
+            }
+        }
+        cout << " Passed." << endl;
+    }
+
+    // Test Case 2: Contradictory constraints leave no arborescence
+    {
+        cout << "  Test Case 2: Contradictions..." << flush;
+        vector<Edge> edges = {{0, 1, 1}, {0, 2, 1}, {1, 2, 1}, {2, 1, 1}, {1, 0, 1}, {2, 2, 1}};
+        EdgeConstraints constraints(3, edges.size());
+        int minWeight = 0;
+        assert(chuLiuEdmonds(3, 0, edges, constraints) == 2);
+        constraints.force(edges, 2);
+        constraints.force(edges, 3);
+        assert(chuLiuEdmonds(3, 0, edges, constraints) == -1);
+        assert(chuLiuEdmondsTarjan(3, 0, edges, minWeight, nullptr, nullptr, nullptr, &constraints) ==
+               EdmondsStatus::NoArborescence);
+        constraints.clear();
+        constraints.force(edges, 4);
+        assert(chuLiuEdmonds(3, 0, edges, constraints) == -1);
+        constraints.clear();
+        constraints.force(edges, 5);
+        assert(chuLiuEdmonds(3, 0, edges, constraints) == -1);
+        constraints.clear();
+        constraints.force(edges, 0);
+        constraints.forbid(0);
+        assert(chuLiuEdmonds(3, 0, edges, constraints) == -1);
+        constraints.clear();
+        constraints.force(edges, 2);
+        constraints.forbid(1);
+        assert(chuLiuEdmonds(3, 0, edges, constraints) == 2);
+        EdgeConstraints wrongSize(3, edges.size() - 1);
+        assert(chuLiuEdmondsTarjan(3, 0, edges, minWeight, nullptr, nullptr, nullptr, &wrongSize) ==
+               EdmondsStatus::InvalidArgument);
+        assert(chuLiuEdmonds(3, 0, edges, wrongSize) == -1);
+        cout << " Passed." << endl;
     }
+
+    cout << "All test cases passed!" << endl;
 }
 
-void testChuLiuEdmonds() {
-    cout << "Running ChuLiuEdmonds Tests..." << endl;
+void testSingleRootChild() {
+    cout << "Running Single Root Child Tests..." << endl;
 
-    // Test Case 1: Simple tree, no cycles
+    // Test Case 1: Random graphs match trying every root child in turn
     {
-        cout << "  Test Case 1: Simple Tree..." << flush;
-        int n = 3;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 10}, {0, 2, 5}};
-        int expected = 15;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected );
+        cout << "  Test Case 1: Every Child..." << flush;
+        for (unsigned seed = 1; seed <= 300; seed++) {
+            int n = 2 + seed % 25;
+            vector<Edge> edges = randomGraph(n, n * (1 + seed % 6), seed);
+            if (seed % 3 == 0) {
+                for (Edge& edge : edges) edge.weight = edge.weight % 7 - 3;
+            }
+            optional<int> expected;
+            EdgeConstraints constraints(n, edges.size());
+            for (size_t chosen = 0; chosen < edges.size(); chosen++) {
+                if (edges[chosen].from != 0 || edges[chosen].to == 0) continue;
+                constraints.clear();
+                for (size_t e = 0; e < edges.size(); e++) {
+                    if (edges[e].from == 0 && e != chosen) constraints.forbid(e);
+                }
+                constraints.force(edges, chosen);
+                int weight = 0;
+                if (chuLiuEdmondsTarjan(n, 0, edges, weight, nullptr, nullptr, nullptr, &constraints) ==
+                        EdmondsStatus::Ok && (!expected || weight < *expected)) {
+                    expected = weight;
+                }
+            }
+            int minWeight = 0;
+            vector<int> parent;
+            EdmondsStatus status = chuLiuEdmondsSingleRootChild(n, 0, edges, minWeight, &parent);
+            if (!expected) {
+                assert(status == EdmondsStatus::NoArborescence);
+                continue;
+            }
+            assert(status == EdmondsStatus::Ok && minWeight == expected);
+            assert(count(parent.begin(), parent.end(), 0) == 1);
+            long long total = 0;
+            for (int v = 1; v < n; v++) {
+                int cheapest = INT_MAX;
+                for (const Edge& edge : edges) {
+                    if (edge.from == parent[v] && edge.to == v) cheapest = min(cheapest, edge.weight);
+                }
+                total += cheapest;
+            }
+            assert(isArborescence(n, 0, edges, parent, total) && total == minWeight);
+        }
         cout << " Passed." << endl;
     }
 
-    // Test Case 2: Simple cycle
+    // Test Case 2: A root that must have two children has no such arborescence
     {
-        cout << "  Test Case 2: Simple Cycle..." << flush;
-        int n = 3;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 10}, {1, 2, 20}, {2, 1, 5}};
-        int expected = 30;
-        int result = chuLiuEdmonds(n, root, edges);
-         assert(result == expected);
+        cout << "  Test Case 2: Impossible..." << flush;
+        vector<Edge> edges = {{0, 1, 1}, {0, 2, 1}, {1, 3, 1}};
+        int minWeight = 0;
+        assert(chuLiuEdmondsSingleRootChild(4, 0, edges, minWeight) == EdmondsStatus::NoArborescence);
+        edges.push_back({3, 2, 50});
+        assert(chuLiuEdmondsSingleRootChild(4, 0, edges, minWeight) == EdmondsStatus::Ok && minWeight == 52);
+        assert(chuLiuEdmondsSingleRootChild(1, 0, {}, minWeight) == EdmondsStatus::Ok && minWeight == 0);
+        assert(chuLiuEdmondsSingleRootChild(4, 4, edges, minWeight) == EdmondsStatus::InvalidArgument);
         cout << " Passed." << endl;
     }
 
-     // Test Case 3: Unreachable node (no incoming edges)
+    // Test Case 3: Weights spanning the int range make the penalty overflow, so children are tried in turn
     {
-        cout << "  Test Case 3: Unreachable Node..." << flush;
-        int n = 3;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 10}};
-        int expected = -1;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 3: Overflow Fallback..." << flush;
+        int n = 40000;
+        vector<Edge> edges = {{0, 1, 0}, {0, 2, 0}, {1, 2, 1000}, {2, 1, 2000}};
+        for (int v = 3; v < n; v++) {
+            edges.push_back({v - 1, v, 0});
+            edges.push_back({1, v, INT_MAX});
+        }
+        assert(!rootChildPenalty(n, 0, edges));
+        int minWeight = 0;
+        vector<int> parent;
+        assert(chuLiuEdmondsSingleRootChild(n, 0, edges, minWeight, &parent) == EdmondsStatus::Ok && minWeight == 1000);
+        assert(count(parent.begin(), parent.end(), 0) == 1 && parent[1] == 0 && parent[2] == 1);
+        assert(isArborescence(n, 0, edges, parent, minWeight));
         cout << " Passed." << endl;
     }
 
-    // Test Case 4: Root unreachable (from some node perspective)
+    cout << "All test cases passed!" << endl;
+}
+
+void testBestRoot() {
+    cout << "Running Best Root Tests..." << endl;
+
+    // Test Case 1: Random graphs match solving from every candidate root
     {
-        cout << "  Test Case 4: Node with no incoming edge..." << flush;
-        int n = 3;
-        int root = 0;
-        vector<Edge> edges = {{1, 0, 10}, {1, 2, 5}};
-        int expected = -1;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 1: Every Root..." << flush;
+        for (unsigned seed = 1; seed <= 300; seed++) {
+            int n = 1 + seed % 25;
+            vector<Edge> edges = randomGraph(n, n * (1 + seed % 4), seed);
+            mt19937 rng(seed);
+            // drop a few edges so that some roots cannot reach everything
+            for (int i = 0; i < n / 3 && !edges.empty(); i++) edges.erase(edges.begin() + rng() % edges.size());
+            for (Edge& edge : edges) edge.from = (edge.from + seed) % n;
+            if (seed % 3 == 0) {
+                for (Edge& edge : edges) edge.weight = edge.weight % 9 - 4;
+            }
+            vector<int> candidates;
+            if (seed % 2) {
+                for (int v = 0; v < n; v++) {
+                    if (rng() % 3) candidates.push_back(v);
+                }
+                if (candidates.empty()) candidates.push_back(0);
+            } else {
+                candidates.resize(n);
+                iota(candidates.begin(), candidates.end(), 0);
+            }
+            optional<int> expected;
+            for (int candidate : candidates) {
+                int weight = 0;
+                if (chuLiuEdmondsTarjan(n, candidate, edges, weight) == EdmondsStatus::Ok && (!expected || weight < *expected)) {
+                    expected = weight;
+                }
+            }
+            int root = -1, minWeight = 0;
+            vector<int> parent;
+            EdmondsStatus status = chuLiuEdmondsBestRoot(n, edges, root, minWeight, &parent, seed % 2 ? candidates : span<const int>());
+            if (!expected) {
+                assert(status == EdmondsStatus::NoArborescence);
+                continue;
+            }
+            assert(status == EdmondsStatus::Ok && minWeight == *expected);
+            assert(find(candidates.begin(), candidates.end(), root) != candidates.end());
+            int rootWeight = 0;
+            assert(chuLiuEdmondsTarjan(n, root, edges, rootWeight) == EdmondsStatus::Ok && rootWeight == minWeight);
+            assert(isArborescence(n, root, edges, parent, minWeight));
+        }
         cout << " Passed." << endl;
     }
 
-
-    // Test Case 5: More Complex Cycle
+    // Test Case 2: Invalid input
     {
-        cout << "  Test Case 5: More Complex Cycle..." << flush;
-        int n = 4;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 10}, {1, 2, 10}, {2, 3, 10}, {3, 1, 10}, {0, 3, 30}};
-        int expected = 30;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 2: Invalid Input..." << flush;
+        vector<Edge> edges = {{0, 1, 5}, {1, 0, 2}, {2, 1, 1}};
+        int root = -1, minWeight = 0;
+        assert(chuLiuEdmondsBestRoot(3, edges, root, minWeight) == EdmondsStatus::Ok && root == 2 && minWeight == 3);
+        vector<int> candidates = {0};
+        assert(chuLiuEdmondsBestRoot(3, edges, root, minWeight, nullptr, candidates) == EdmondsStatus::NoArborescence);
+        candidates = {3};
+        assert(chuLiuEdmondsBestRoot(3, edges, root, minWeight, nullptr, candidates) == EdmondsStatus::InvalidArgument);
+        assert(chuLiuEdmondsBestRoot(0, {}, root, minWeight) == EdmondsStatus::InvalidArgument);
+        assert(chuLiuEdmondsBestRoot(1, {}, root, minWeight) == EdmondsStatus::Ok && root == 0 && minWeight == 0);
+        vector<Edge> outOfRange = {{0, 1, 5}, {1, 2, 5}, {3, 1, -100}};
+        assert(chuLiuEdmondsBestRoot(3, outOfRange, root, minWeight) == EdmondsStatus::InvalidArgument);
+        outOfRange = {{0, 1, 5}, {1, 2, 5}, {0, -1, 1}};
+        assert(chuLiuEdmondsBestRoot(3, outOfRange, root, minWeight) == EdmondsStatus::InvalidArgument);
         cout << " Passed." << endl;
     }
 
-    // Test Case 6: Disconnected Graph (nodes unreachable from root component)
+    // Test Case 3: Weights spanning the int range make the penalty overflow, so candidates are solved in turn
     {
-        cout << "  Test Case 6: Disconnected Graph..." << flush;
-        int n = 4;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 10}, {2, 3, 5}}; 
-        int expected = -1;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 3: Overflow Fallback..." << flush;
+        int n = 40000;
+        vector<Edge> edges = {{0, 1, 0}, {0, 2, 0}, {1, 2, 1000}, {2, 1, 2000}, {1, 0, -5}};
+        for (int v = 3; v < n; v++) {
+            edges.push_back({v - 1, v, 0});
+            edges.push_back({1, v, INT_MAX});
+        }
+        vector<int> candidates = {0, 1};
+        vector<Edge> augmented = edges;
+        for (int candidate : candidates) augmented.push_back({n, candidate, 0});
+        assert(!rootChildPenalty(n + 1, n, augmented));
+        int root = -1, minWeight = 0;
+        vector<int> parent;
+        assert(chuLiuEdmondsBestRoot(n, edges, root, minWeight, &parent, candidates) == EdmondsStatus::Ok);
+        assert(root == 1 && minWeight == -5 && parent[0] == 1 && parent[2] == 0);
+        assert(isArborescence(n, root, edges, parent, minWeight));
         cout << " Passed." << endl;
     }
 
-    // Test Case 7: Single Node
+    cout << "All test cases passed!" << endl;
+}
+
+void testMinimumBranching() {
+    cout << "Running Minimum Branching Tests..." << endl;
+
+    // Test Case 1: Small graphs match every branching enumerated by brute force
     {
-        cout << "  Test Case 7: Single Node..." << flush;
-        int n = 1;
-        int root = 0;
-        vector<Edge> edges = {};
-        int expected = 0;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 1: Brute Force..." << flush;
+        for (unsigned seed = 1; seed <= 200; seed++) {
+            int n = 1 + seed % 6;
+            vector<Edge> edges = randomGraph(n, n * (1 + seed % 3), seed);
+            for (Edge& edge : edges) edge.weight = edge.weight % 21 - 12;
+            // each node picks one of its in-edges, or none (the last choice)
+            vector<vector<int>> into(n);
+            for (size_t e = 0; e < edges.size(); e++) {
+                if (edges[e].from != edges[e].to) into[edges[e].to].push_back((int)e);
+            }
+            vector<size_t> choice(n, 0);
+            int expected = 0;
+            for (;;) {
+                vector<int> parent(n, -1);
+                int total = 0;
+                for (int v = 0; v < n; v++) {
+                    if (choice[v] < into[v].size()) {
+                        parent[v] = edges[into[v][choice[v]]].from;
+                        total += edges[into[v][choice[v]]].weight;
+                    }
+                }
+                bool acyclic = true;
+                for (int v = 0; v < n && acyclic; v++) {
+                    int steps = 0;
+                    for (int u = v; u >= 0 && acyclic; u = parent[u]) acyclic = ++steps <= n;
+                }
+                if (acyclic) expected = min(expected, total);
+                int v = 0;
+                while (v < n && ++choice[v] > into[v].size()) choice[v++] = 0;
+                if (v == n) break;
+            }
+            int minWeight = 1;
+            vector<int> parent;
+            assert(minimumBranching(n, edges, minWeight, &parent) == EdmondsStatus::Ok);
+            assert(minWeight == expected && (int)parent.size() == n);
+            long long total = 0;
+            for (int v = 0; v < n; v++) {
+                if (parent[v] < 0) continue;
+                int cheapest = INT_MAX;
+                for (const Edge& edge : edges) {
+                    if (edge.from == parent[v] && edge.to == v) cheapest = min(cheapest, edge.weight);
+                }
+                assert(cheapest < INT_MAX);
+                total += cheapest;
+                int steps = 0;
+                for (int u = v; u >= 0; u = parent[u]) assert(++steps <= n);
+            }
+            assert(total == minWeight);
+        }
         cout << " Passed." << endl;
     }
 
-     // Test Case 8: Two Nodes, Path Exists
+    // Test Case 2: Positive edges are left out and unreachable nodes become roots
     {
-        cout << "  Test Case 8: Two Nodes Path..." << flush;
-        int n = 2;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 5}};
-        int expected = 5;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 2: Several Sources..." << flush;
+        vector<Edge> edges = {{0, 1, 3}, {2, 3, -4}, {3, 2, -1}, {3, 4, -2}, {4, 3, -7}};
+        int minWeight = 0;
+        vector<int> parent;
+        assert(minimumBranching(5, edges, minWeight, &parent) == EdmondsStatus::Ok && minWeight == -8);
+        assert((parent == vector<int>{-1, -1, 3, 4, -1}));
+        assert(minimumBranching(0, edges, minWeight) == EdmondsStatus::InvalidArgument);
+        assert(minimumBranching(2, edges, minWeight) == EdmondsStatus::InvalidArgument);
+        assert(minimumBranching(4, edges, minWeight) == EdmondsStatus::InvalidArgument);
         cout << " Passed." << endl;
     }
 
-    // Test Case 9: Two Nodes, No Path
+    cout << "All test cases passed!" << endl;
+}
+
+void testReachableArborescence() {
+    cout << "Running Reachable Arborescence Tests..." << endl;
+
+    // Test Case 1: Graphs with unreachable nodes match a solve over the reachable ones
     {
-        cout << "  Test Case 9: Two Nodes No Path..." << flush;
-        int n = 2;
-        int root = 0;
-        vector<Edge> edges = {};
-        int expected = -1;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 1: Unreachable Nodes..." << flush;
+        for (unsigned seed = 1; seed <= 200; seed++) {
+            int n = 1 + seed % 40;
+            vector<Edge> edges = randomGraph(n, n * (1 + seed % 3), seed);
+            mt19937 rng(seed);
+            // cut every edge into a few nodes, which may cut off what lies behind them
+            vector<char> cut(n, 0);
+            for (int i = 0; i < 1 + n / 8 && n > 1; i++) cut[1 + rng() % (n - 1)] = 1;
+            erase_if(edges, [&](const Edge& edge) { return cut[edge.to]; });
+            vector<char> reached(n, 0);
+            reached[0] = 1;
+            for (bool grown = true; grown;) {
+                grown = false;
+                for (const Edge& edge : edges) {
+                    if (reached[edge.from] && !reached[edge.to]) reached[edge.to] = grown = true;
+                }
+            }
+            vector<int> expectedExcluded, number(n, -1);
+            vector<Edge> induced;
+            int reachedCount = 0;
+            for (int v = 0; v < n; v++) {
+                if (reached[v]) number[v] = reachedCount++;
+                else expectedExcluded.push_back(v);
+            }
+            for (const Edge& edge : edges) {
+                if (reached[edge.from] && reached[edge.to]) induced.push_back({number[edge.from], number[edge.to], edge.weight});
+            }
+            int minWeight = 0;
+            vector<int> excluded, parent;
+            assert(chuLiuEdmondsReachable(n, 0, edges, minWeight, excluded, &parent) == EdmondsStatus::Ok);
+            assert(excluded == expectedExcluded);
+            assert(minWeight == chuLiuEdmonds(reachedCount, 0, induced));
+            long long total = 0;
+            for (int v = 0; v < n; v++) {
+                if (!reached[v] || v == 0) {
+                    assert(parent[v] == -1);
+                    continue;
+                }
+                assert(reached[parent[v]]);
+                int cheapest = INT_MAX;
+                for (const Edge& edge : edges) {
+                    if (edge.from == parent[v] && edge.to == v) cheapest = min(cheapest, edge.weight);
+                }
+                total += cheapest;
+                int steps = 0;
+                for (int u = v; u != 0; u = parent[u]) assert(++steps <= n);
+            }
+            assert(total == minWeight);
+        }
         cout << " Passed." << endl;
     }
 
-    // Test Case 10: Negative Weights, No Cycle
+    // Test Case 2: A fully reachable graph is solved as is, and bad input is rejected
     {
-        cout << "  Test Case 10: Negative Weights No Cycle..." << flush;
-        int n = 3;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 10}, {1, 2, -5}, {0, 2, 8}};
-        int expected = 5;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 2: Fully Reachable..." << flush;
+        vector<Edge> edges = randomGraph(300, 3000, 11);
+        int minWeight = 0;
+        vector<int> excluded = {1}, parent;
+        assert(chuLiuEdmondsReachable(300, 0, edges, minWeight, excluded, &parent) == EdmondsStatus::Ok);
+        assert(excluded.empty() && minWeight == chuLiuEdmonds(300, 0, edges));
+        assert(isArborescence(300, 0, edges, parent, minWeight));
+        assert(chuLiuEdmondsReachable(300, 300, edges, minWeight, excluded) == EdmondsStatus::InvalidArgument);
+        edges.push_back({0, 300, 1});
+        assert(chuLiuEdmondsReachable(300, 0, edges, minWeight, excluded) == EdmondsStatus::InvalidArgument);
         cout << " Passed." << endl;
     }
 
-     // Test Case 11: Negative Weights with Cycle
+    cout << "All test cases passed!" << endl;
+}
+
+void testKBestArborescences() {
+    cout << "Running K Best Arborescences Tests..." << endl;
+
+    // Test Case 1: Small graphs match every arborescence enumerated by brute force
     {
-        cout << "  Test Case 11: Negative Weights Cycle..." << flush;
-        int n = 3;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 10}, {1, 2, 5}, {2, 1, -8}};
-        int expected = 15;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected);
+        cout << "  Test Case 1: Brute Force..." << flush;
+        // parallel edges make distinct arborescences, so check reachability rather than isArborescence
+        auto reachesRoot = [](int n, const vector<int>& parent) {
+            for (int v = 1; v < n; v++) {
+                int steps = 0;
+                for (int u = v; u != 0; u = parent[u]) {
+                    if (++steps > n) return false;
+                }
+            }
+            return true;
+        };
+        for (unsigned seed = 1; seed <= 60; seed++) {
+            int n = 2 + seed % 5;
+            vector<Edge> edges = randomGraph(n, n * (1 + seed % 4), seed);
+            if (seed % 3 == 0) {
+                for (Edge& edge : edges) edge.weight %= 4;
+            }
+            vector<vector<int>> into(n);
+            for (size_t e = 0; e < edges.size(); e++) into[edges[e].to].push_back((int)e);
+            vector<int> totals;
+            vector<size_t> choice(n, 0);
+            bool some = true;
+            for (int v = 1; v < n; v++) some &= !into[v].empty();
+            while (some) {
+                vector<int> parent(n, -1);
+                int total = 0;
+                for (int v = 1; v < n; v++) {
+                    parent[v] = edges[into[v][choice[v]]].from;
+                    total += edges[into[v][choice[v]]].weight;
+                }
+                if (reachesRoot(n, parent)) totals.push_back(total);
+                int v = 1;
+                while (v < n && ++choice[v] == into[v].size()) choice[v++] = 0;
+                if (v == n) break;
+            }
+            sort(totals.begin(), totals.end());
+            int k = 1 + (int)(seed % 20);
+            vector<RankedArborescence> best;
+            EdmondsStatus status = kBestArborescences(n, 0, edges, k, best);
+            if (totals.empty()) {
+                assert(status == EdmondsStatus::NoArborescence && best.empty());
+                continue;
+            }
+            assert(status == EdmondsStatus::Ok);
+            assert(best.size() == min((size_t)k, totals.size()));
+            vector<vector<int>> seen;
+            for (size_t i = 0; i < best.size(); i++) {
+                assert(best[i].total == totals[i] && reachesRoot(n, best[i].parent));
+                int total = 0;
+                for (int v = 1; v < n; v++) {
+                    assert(edges[best[i].inEdge[v]].to == v && edges[best[i].inEdge[v]].from == best[i].parent[v]);
+                    total += edges[best[i].inEdge[v]].weight;
+                }
+                assert(total == best[i].total);
+                seen.push_back(best[i].inEdge);
+            }
+            sort(seen.begin(), seen.end());
+            assert(adjacent_find(seen.begin(), seen.end()) == seen.end());
+        }
         cout << " Passed." << endl;
     }
 
-     // Test Case 12: Alternative Path Chosen After Contraction
+    // Test Case 2: The first arborescence is the minimum one
     {
-        cout << "  Test Case 12: Alt Path Post-Contraction..." << flush;
-        int n = 4;
-        int root = 0;
-        vector<Edge> edges = {{0, 1, 10}, {0, 2, 12}, {1, 2, 5}, {2, 1, 3}, {0, 3, 20}};
-        vector<Edge> edges_copy = edges;
-        int expected = 35;
-        int result = chuLiuEdmonds(n, root, edges);
-        assert(result == expected );
+        cout << "  Test Case 2: Best First..." << flush;
+        vector<Edge> edges = randomGraph(200, 3000, 7);
+        vector<RankedArborescence> best;
+        assert(kBestArborescences(200, 0, edges, 30, best) == EdmondsStatus::Ok && best.size() == 30);
+        assert(best[0].total == chuLiuEdmonds(200, 0, edges));
+        for (size_t i = 1; i < best.size(); i++) assert(best[i - 1].total <= best[i].total);
         cout << " Passed." << endl;
     }
 
-    // Test Case 13: Two Disjoint Cycles
+    // Test Case 3: Invalid input
     {
-        cout << "  Test Case 13: Two Disjoint Cycles..." << flush;
-        int n = 5;
-        int root = 4;
-        vector<Edge> edges = {
-            {4, 0, 10}, {0, 1, 5}, {1, 0, 6},
-            {4, 2, 12}, {2, 3, 7}, {3, 2, 8},
-            {4, 1, 18}, {4, 3, 22}
-        };
-        vector<Edge> edges_copy = edges;
-        int expected = 34;
-        int result = chuLiuEdmonds(n, root, edges_copy);
-        assert(result == expected);
+        cout << "  Test Case 3: Invalid Input..." << flush;
+        vector<Edge> edges = {{0, 1, 1}, {1, 2, 1}};
+        vector<RankedArborescence> best;
+        assert(kBestArborescences(3, 0, edges, 0, best) == EdmondsStatus::Ok && best.empty());
+        assert(kBestArborescences(3, 0, edges, 5, best) == EdmondsStatus::Ok && best.size() == 1);
+        assert(kBestArborescences(3, 5, edges, 5, best) == EdmondsStatus::InvalidArgument && best.empty());
         cout << " Passed." << endl;
     }
 
@@ -309,8 +7145,526 @@ void runChuLiuEdmondsSample() {
     cout << "Chu-Liu-Edmonds Sample Result: " << result << endl;
 }
 
-int main() {
+void runChuLiuEdmondsBenchmark() {
+    cout << "Running ChuLiuEdmonds Benchmark..." << endl;
+    const int sizes[][2] = {{100, 1000}, {1000, 20000}, {5000, 100000}};
+    for (const auto& size : sizes) {
+        int n = size[0], m = size[1];
+        vector<Edge> edges = randomGraph(n, m, 42);
+        CountingMemoryResource counter;
+        auto start = chrono::steady_clock::now();
+        int result = chuLiuEdmonds(n, 0, edges, &counter);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  n=" << n << " E=" << m << ": " << ms << " ms, result " << result
+             << ", " << counter.allocations() << " allocations, " << counter.bytesAllocated()
+             << " bytes, peak " << counter.peakBytes() << " bytes" << endl;
+
+        size_t arenaBytes = 0;
+        start = chrono::steady_clock::now();
+        result = chuLiuEdmondsInArena(n, 0, edges, &arenaBytes);
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  n=" << n << " E=" << m << " (arena): " << ms << " ms, result " << result
+             << ", " << arenaBytes << " arena bytes" << endl;
+
+        CompressedGraph compressed(n, edges);
+        start = chrono::steady_clock::now();
+        chuLiuEdmonds(n, 0, compressed, result);
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  n=" << n << " E=" << m << " (compressed): " << ms << " ms, result " << result << ", "
+             << (double)compressed.bytes() / m << " bytes per edge" << endl;
+
+        start = chrono::steady_clock::now();
+        chuLiuEdmondsTarjan(n, 0, edges, result);
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  n=" << n << " E=" << m << " (tarjan): " << ms << " ms, result " << result << endl;
+
+        SolveStop stop;
+        stop.deadline = chrono::steady_clock::now() + chrono::hours(1);
+        EdmondsWorkspaceSize needed = requiredWorkspace(n, edges.size());
+        vector<int> nodeInts(EdmondsWorkspace::NODE_ARRAYS * needed.nodeInts);
+        vector<Edge> scratch(needed.scratchEdges);
+        span<int> ints(nodeInts);
+        EdmondsWorkspace workspace = {ints.subspan(0, n), ints.subspan(n, n), ints.subspan(2 * n, n),
+                                      ints.subspan(3 * n, n), ints.subspan(4 * n, n), scratch};
+        start = chrono::steady_clock::now();
+        chuLiuEdmonds(n, 0, edges, workspace, result, &stop);
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  n=" << n << " E=" << m << " (with deadline checks): " << ms << " ms, result " << result << endl;
+    }
+}
+
+void runGraphFileBenchmark() {
+    cout << "Running Graph File Benchmark..." << endl;
+    int n = 100000, m = 2000000;
+    vector<Edge> edges = randomGraph(n, m, 42);
+    string textPath = (filesystem::temp_directory_path() / "edmonds_bench_graph.txt").string();
+    string binaryPath = (filesystem::temp_directory_path() / "edmonds_bench_graph.bin").string();
+    {
+        ofstream text(textPath);
+        for (const Edge& edge : edges) {
+            text << edge.from << ' ' << edge.to << ' ' << edge.weight << '\n';
+        }
+    }
+    writeGraphFile(binaryPath, n, 0, edges);
+
+    auto start = chrono::steady_clock::now();
+    vector<Edge> parsed;
+    ifstream text(textPath);
+    readTextEdgeList(text, parsed);
+    long long textSum = 0;
+    for (const Edge& edge : parsed) textSum += edge.weight;
+    double textMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    start = chrono::steady_clock::now();
+    ParsedEdgeList parallel;
+    loadEdgeList(textPath, EdgeListFormat::Triples, parallel);
+    double parallelMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    double megabytes = filesystem::file_size(textPath) / 1e6;
+    assert(parallel.edges.size() == edges.size());
+
+    start = chrono::steady_clock::now();
+    MappedGraph graph;
+    graph.open(binaryPath);
+    double mapMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    long long mappedSum = 0;
+    for (const Edge& edge : graph.edges()) mappedSum += edge.weight;
+    double scanMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    assert(textSum == mappedSum);
+
+    // The semi-external solver repeats a full pass per round, so it runs on a graph with fewer rounds
+    int semiN = 5000, semiM = 100000;
+    vector<Edge> semiEdges = randomGraph(semiN, semiM, 42);
+    string semiPath = (filesystem::temp_directory_path() / "edmonds_bench_semi.bin").string();
+    writeGraphFile(semiPath, semiN, 0, semiEdges);
+    start = chrono::steady_clock::now();
+    int semiExternalWeight = 0;
+    SemiExternalStats stats;
+    EdmondsStatus semiExternalStatus = chuLiuEdmondsSemiExternal(semiPath, semiExternalWeight, {}, &stats);
+    double semiExternalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    assert(semiExternalStatus == EdmondsStatus::Ok);
+    SemiExternalOptions threaded;
+    threaded.ioBackend = IoBackend::Threads;
+    start = chrono::steady_clock::now();
+    int threadedWeight = 0;
+    EdmondsStatus threadedStatus = chuLiuEdmondsSemiExternal(semiPath, threadedWeight, threaded);
+    double threadedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    assert(threadedStatus == EdmondsStatus::Ok && threadedWeight == semiExternalWeight);
+    start = chrono::steady_clock::now();
+    int inMemoryWeight = chuLiuEdmonds(semiN, 0, semiEdges);
+    double inMemoryMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    assert(inMemoryWeight == semiExternalWeight);
+    filesystem::remove(semiPath);
+
+    cout << "  n=" << n << " E=" << m << ": text parse + scan " << textMs << " ms, parallel from_chars parse "
+         << parallelMs << " ms (" << megabytes / (parallelMs / 1000) << " MB/s on "
+         << thread::hardware_concurrency() << " threads), mmap load " << mapMs
+         << " ms, mmap load + scan " << scanMs << " ms" << endl;
+    cout << "  n=" << semiN << " E=" << semiM << ": semi-external solve "
+         << (stats.ioBackend == IoBackend::IoUring ? "(io_uring) " : "(threads) ") << semiExternalMs << " ms over "
+         << stats.rounds << " rounds (" << stats.bytesRead / 1e6 << " MB read, " << stats.bytesWritten / 1e6
+         << " MB written), with thread I/O " << threadedMs << " ms, in-memory solve " << inMemoryMs << " ms" << endl;
+    filesystem::remove(textPath);
+    filesystem::remove(binaryPath);
+}
+
+void runBatchPipelineBenchmark() {
+    cout << "Running Batch Pipeline Benchmark..." << endl;
+    int graphs = 200, n = 2000, m = 40000;
+    string path = (filesystem::temp_directory_path() / "edmonds_bench_batch.bin").string();
+    BatchFileWriter writer;
+    writer.open(path);
+    for (int g = 0; g < graphs; g++) writer.append(n, 0, randomGraph(n, m, g));
+    writer.close();
+
+    long long sequentialSum = 0;
+    auto start = chrono::steady_clock::now();
+    BatchFileReader reader;
+    reader.open(path);
+    BatchGraph graph;
+    while (reader.next(graph)) {
+        int total = 0;
+        vector<int> parent;
+        chuLiuEdmondsTarjan(graph.n, graph.root, graph.edges, total, &parent);
+        sequentialSum += total;
+    }
+    double sequentialMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    long long pipelinedSum = 0;
+    start = chrono::steady_clock::now();
+    runBatchPipeline(path, [&](const BatchResult& result) { pipelinedSum += result.total; });
+    double pipelinedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    assert(sequentialSum == pipelinedSum);
+
+    cout << "  " << graphs << " graphs of n=" << n << " E=" << m << ": sequential read + solve " << sequentialMs
+         << " ms, pipelined " << pipelinedMs << " ms" << endl;
+
+    vector<BatchResult> results;
+    runBatchPipeline(path, [&](BatchResult& result) { results.push_back(move(result)); });
+    string textPath = path + ".txt", resultPath = path + ".results";
+    start = chrono::steady_clock::now();
+    {
+        ofstream text(textPath);
+        for (const BatchResult& result : results) {
+            text << result.index << ' ' << (int)result.status << ' ' << result.total;
+            for (int p : result.parent) text << ' ' << p;
+            text << '\n';
+        }
+    }
+    double textMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    {
+        ResultFileWriter writer;
+        writer.open(resultPath);
+        for (BatchResult& result : results) writer.append(move(result));
+        writer.close();
+    }
+    double binaryMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "  writing " << graphs << " results with parents: text " << textMs << " ms ("
+         << filesystem::file_size(textPath) / 1e6 << " MB), binary writev " << binaryMs << " ms ("
+         << filesystem::file_size(resultPath) / 1e6 << " MB)" << endl;
+    filesystem::remove(textPath);
+    filesystem::remove(resultPath);
+    filesystem::remove(path);
+}
+
+void runSolverDaemonBenchmark() {
+    cout << "Running Solver Daemon Benchmark..." << endl;
+    string socketPath = (filesystem::temp_directory_path() / "edmonds_bench_daemon.sock").string();
+    SolverDaemon daemon;
+    daemon.start(socketPath);
+    int clients = 8, requests = 500, n = 100;
+    vector<Edge> edges = randomGraph(n, n * 10, 42);
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int c = 0; c < clients; c++) {
+        workers.emplace_back([&] {
+            SolverClient client;
+            client.connect(socketPath);
+            BatchResult result;
+            for (int r = 0; r < requests; r++) client.solve(n, 0, edges, result);
+        });
+    }
+    for (thread& worker : workers) worker.join();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    SolverClient client;
+    client.connect(socketPath);
+    DaemonStats stats;
+    client.stats(stats);
+    cout << "  " << clients << " clients x " << requests << " requests of n=" << n << " E=" << n * 10 << ": "
+         << clients * requests / (ms / 1000) << " requests/s, " << stats.batches << " batches (max queue depth "
+         << stats.maxQueueDepth << "), latency p50 " << stats.p50Micros << " us, p90 " << stats.p90Micros
+         << " us, p99 " << stats.p99Micros << " us" << endl;
+    daemon.stop();
+}
+
+void runResultCacheBenchmark() {
+    cout << "Running Result Cache Benchmark..." << endl;
+    vector<Edge> large = randomGraph(100000, 2000000, 42);
+    auto start = chrono::steady_clock::now();
+    GraphHash hash = hashGraph(100000, 0, large);
+    double hashMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    int distinct = 50, requests = 2000, n = 500;
+    vector<vector<Edge>> graphs;
+    for (int g = 0; g < distinct; g++) graphs.push_back(randomGraph(n, n * 10, g));
+    double ms[2];
+    ResultCache cache;
+    for (int cached = 0; cached < 2; cached++) {
+        BatchSolver solver(BatchEngine::Tarjan, cached ? &cache : nullptr);
+        BatchResult result;
+        start = chrono::steady_clock::now();
+        for (int r = 0; r < requests; r++) solver.solve(n, 0, graphs[r % distinct], result);
+        ms[cached] = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    cout << "  hash of E=" << large.size() << ": " << hashMs << " ms (" << large.size() * sizeof(Edge) / 1e6 / hashMs
+         << " GB/s, " << hex << hash.high << dec << ")" << endl;
+    cout << "  " << requests << " solves of " << distinct << " distinct graphs n=" << n << " E=" << n * 10
+         << ": uncached " << ms[0] << " ms, cached " << ms[1] << " ms (" << cache.hits() << " hits, "
+         << cache.misses() << " misses)" << endl;
+}
+
+void runDynamicArborescenceBenchmark() {
+    cout << "Running Dynamic Arborescence Benchmark..." << endl;
+    int n = 10000, m = 100000, updates = 4000;
+    vector<Edge> edges = randomGraph(n, m, 42);
+    int result = 0;
+    auto start = chrono::steady_clock::now();
+    chuLiuEdmondsTarjan(n, 0, edges, result);
+    double fullMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "  n=" << n << " E=" << m << ": full solve " << fullMs << " ms" << endl;
+
+    // batch updates are applied between queries; recomputing costs one full solve per batch
+    for (int batch : {1, 10, 100, 1000}) {
+        DynamicArborescence dynamic(n, 0, edges);
+        mt19937 rng(7);
+        start = chrono::steady_clock::now();
+        for (int update = 1; update <= updates; update++) {
+            int index = rng() % dynamic.edgeList().size();
+            int weight = dynamic.edgeList()[index].weight;
+            switch (rng() % 4) {
+                case 0: dynamic.addEdge(rng() % n, rng() % n, 1 + rng() % 1000); break;
+                case 1: dynamic.removeEdge(index); break;
+                case 2: dynamic.increaseWeight(index, weight + rng() % 100); break;
+                default: dynamic.decreaseWeight(index, weight - rng() % 100); break;
+            }
+            if (update % batch == 0) result = dynamic.minWeight();
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  " << batch << " updates per query: dynamic " << ms * batch / updates << " ms, recompute "
+             << fullMs << " ms per query (" << dynamic.fastUpdateCount() << " without solving, "
+             << dynamic.localResolveCount() << " local, " << dynamic.resolveCount() - 1 << " full re-solves), result "
+             << result << endl;
+    }
+}
+
+void runWarmStartBenchmark() {
+    cout << "Running Warm Start Benchmark..." << endl;
+    int n = 5000, m = 100000, steps = 20, changes = 100;
+    vector<Edge> edges = randomGraph(n, m, 42);
+    mt19937 rng(7);
+    WarmStart warm;
+    int result = 0;
+    chuLiuEdmondsWarm(n, 0, edges, warm, result);
+    double ms[3] = {0, 0, 0};
+    int reusedCount = 0;
+    for (int step = 0; step < steps; step++) {
+        for (int change = 0; change < changes; change++) edges[rng() % m].weight += (int)(rng() % 11) - 5;
+        auto start = chrono::steady_clock::now();
+        bool reused = false;
+        chuLiuEdmondsWarm(n, 0, edges, warm, result, &reused);
+        reusedCount += reused;
+        ms[0] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        chuLiuEdmondsTarjan(n, 0, edges, result);
+        ms[1] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        result = chuLiuEdmonds(n, 0, edges);
+        ms[2] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    cout << "  n=" << n << " E=" << m << ", " << changes << " weights drifting per solve: warm " << ms[0] / steps
+         << " ms (" << reusedCount << "/" << steps << " reused), cold tarjan " << ms[1] / steps << " ms, cold rounds "
+         << ms[2] / steps << " ms, result " << result << endl;
+}
+
+void runEdgeConstraintsBenchmark() {
+    cout << "Running Edge Constraints Benchmark..." << endl;
+    int n = 1000, m = 20000;
+    vector<Edge> edges = randomGraph(n, m, 42);
+    ArborescenceDuals duals;
+    int result = 0;
+    chuLiuEdmondsTarjan(n, 0, edges, result, nullptr, nullptr, &duals);
+    mt19937 rng(7);
+    const int variants[] = {200, 20};
+    for (int tarjan = 1; tarjan >= 0; tarjan--) {
+        double ms[2] = {0, 0};
+        int masked = 0, copied = 0;
+        for (int variant = 0; variant < variants[1 - tarjan]; variant++) {
+            EdgeConstraints constraints(n, m);
+            for (int i = 0; i < 5; i++) constraints.force(edges, duals.inEdge[1 + rng() % (n - 1)]);
+            for (int i = 0; i < 200; i++) {
+                size_t e = rng() % m;
+                if (!constraints.forced(e)) constraints.forbid(e);
+            }
+            auto start = chrono::steady_clock::now();
+            if (tarjan) chuLiuEdmondsTarjan(n, 0, edges, masked, nullptr, nullptr, nullptr, &constraints);
+            else masked = chuLiuEdmonds(n, 0, edges, constraints);
+            ms[0] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            start = chrono::steady_clock::now();
+            vector<Edge> filtered;
+            for (int e = 0; e < m; e++) {
+                if (constraints.allowed(e, edges[e].to)) filtered.push_back(edges[e]);
+            }
+            if (tarjan) chuLiuEdmondsTarjan(n, 0, filtered, copied);
+            else copied = chuLiuEdmonds(n, 0, filtered);
+            ms[1] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        }
+        cout << "  n=" << n << " E=" << m << " (" << (tarjan ? "tarjan" : "rounds") << "), 5 forced and 200 forbidden edges: masked "
+             << ms[0] / variants[1 - tarjan] << " ms, filtered copy " << ms[1] / variants[1 - tarjan]
+             << " ms per variant, result " << masked << (masked == copied ? "" : " (mismatch)") << endl;
+    }
+}
+
+void runSingleRootChildBenchmark() {
+    cout << "Running Single Root Child Benchmark..." << endl;
+    int n = 100, sentences = 50, multiple = 0;
+    double ms[2] = {0, 0};
+    for (int sentence = 0; sentence < sentences; sentence++) {
+        mt19937 rng(sentence);
+        vector<Edge> edges;
+        for (int u = 0; u < n; u++) {
+            for (int v = 1; v < n; v++) {
+                if (u != v) edges.push_back({u, v, (int)(rng() % 1000) - (u == 0 ? 400 : 0)});
+            }
+        }
+        vector<int> parent;
+        int plain = 0, single = 0, perChild = INT_MAX;
+        chuLiuEdmondsTarjan(n, 0, edges, plain, &parent);
+        multiple += count(parent.begin(), parent.end(), 0) > 1;
+        auto start = chrono::steady_clock::now();
+        chuLiuEdmondsSingleRootChild(n, 0, edges, single);
+        ms[0] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        start = chrono::steady_clock::now();
+        EdgeConstraints constraints(n, edges.size());
+        for (int child = 1; child < n; child++) {
+            constraints.clear();
+            for (size_t e = 0; e < edges.size(); e++) {
+                if (edges[e].from != 0) continue;
+                if (edges[e].to == child) constraints.force(edges, e);
+                else constraints.forbid(e);
+            }
+            int weight = 0;
+            if (chuLiuEdmondsTarjan(n, 0, edges, weight, nullptr, nullptr, nullptr, &constraints) == EdmondsStatus::Ok) {
+                perChild = min(perChild, weight);
+            }
+        }
+        ms[1] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (single != perChild) cout << "  mismatch on sentence " << sentence << endl;
+    }
+    cout << "  " << sentences << " complete graphs of n=" << n << " (" << multiple << " with several root children unconstrained): "
+         << "single root child " << ms[0] / sentences << " ms, one solve per child " << ms[1] / sentences << " ms" << endl;
+}
+
+void runBestRootBenchmark() {
+    cout << "Running Best Root Benchmark..." << endl;
+    int n = 500, m = 10000;
+    vector<Edge> edges = randomGraph(n, m, 42);
+    for (Edge& edge : edges) edge.from = (edge.from + 17) % n;
+    int root = -1, result = 0;
+    auto start = chrono::steady_clock::now();
+    chuLiuEdmondsBestRoot(n, edges, root, result);
+    double single = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    int best = INT_MAX, bestRoot = -1;
+    for (int candidate = 0; candidate < n; candidate++) {
+        int weight = 0;
+        if (chuLiuEdmondsTarjan(n, candidate, edges, weight) == EdmondsStatus::Ok && weight < best) {
+            best = weight;
+            bestRoot = candidate;
+        }
+    }
+    double every = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "  n=" << n << " E=" << m << ": virtual super-root " << single << " ms (root " << root << ", " << result
+         << "), every root " << every << " ms (root " << bestRoot << ", " << best << ")" << endl;
+}
+
+void runMinimumBranchingBenchmark() {
+    cout << "Running Minimum Branching Benchmark..." << endl;
+    int n = 5000, m = 100000;
+    vector<Edge> edges = randomGraph(n, m, 42);
+    for (Edge& edge : edges) edge.weight -= 500;
+    int branching = 0, arborescence = 0;
+    vector<int> parent;
+    auto start = chrono::steady_clock::now();
+    minimumBranching(n, edges, branching, &parent);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    chuLiuEdmondsTarjan(n, 0, edges, arborescence);
+    double rooted = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "  n=" << n << " E=" << m << ": branching " << ms << " ms (" << branching << ", "
+         << count(parent.begin(), parent.end(), -1) << " roots), arborescence from node 0 " << rooted << " ms ("
+         << arborescence << ")" << endl;
+}
+
+void runReachableArborescenceBenchmark() {
+    cout << "Running Reachable Arborescence Benchmark..." << endl;
+    int n = 100000, m = 2000000;
+    vector<Edge> edges = randomGraph(n, m, 42);
+    // cut a handful of nodes off from the root
+    erase_if(edges, [](const Edge& edge) { return edge.to % 20000 == 7; });
+    int result = 0;
+    vector<int> excluded;
+    auto start = chrono::steady_clock::now();
+    chuLiuEdmondsReachable(n, 0, edges, result, excluded);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    int whole = 0;
+    EdmondsStatus status = chuLiuEdmondsTarjan(n, 0, edges, whole);
+    double failed = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "  n=" << n << " E=" << edges.size() << ": reachable part " << ms << " ms (" << result << ", "
+         << excluded.size() << " nodes excluded), whole graph " << failed << " ms ("
+         << (status == EdmondsStatus::Ok ? "ok" : "no arborescence") << ")" << endl;
+}
+
+void runKBestBenchmark() {
+    cout << "Running K Best Arborescences Benchmark..." << endl;
+    int n = 100;
+    mt19937 rng(42);
+    vector<Edge> edges;
+    for (int u = 0; u < n; u++) {
+        for (int v = 1; v < n; v++) {
+            if (u != v) edges.push_back({u, v, 1 + (int)(rng() % 1000)});
+        }
+    }
+    for (int k : {1, 10, 50, 200}) {
+        vector<RankedArborescence> best;
+        auto start = chrono::steady_clock::now();
+        kBestArborescences(n, 0, edges, k, best);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << "  n=" << n << " E=" << edges.size() << " k=" << k << ": " << ms << " ms, weights "
+             << best.front().total << ".." << best.back().total << endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && string(argv[1]) == "--bench") {
+        runChuLiuEdmondsBenchmark();
+        runGraphFileBenchmark();
+        runBatchPipelineBenchmark();
+        runSolverDaemonBenchmark();
+        runResultCacheBenchmark();
+        runDynamicArborescenceBenchmark();
+        runWarmStartBenchmark();
+        runEdgeConstraintsBenchmark();
+        runKBestBenchmark();
+        runSingleRootChildBenchmark();
+        runBestRootBenchmark();
+        runMinimumBranchingBenchmark();
+        runReachableArborescenceBenchmark();
+        return 0;
+    }
+    if (argc == 4 && string(argv[1]) == "--solve-batch") {
+        return solveBatchFile(argv[2], argv[3]) ? 0 : 1;
+    }
+    if (argc == 3 && string(argv[1]) == "--serve") {
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        SolverDaemon daemon;
+        if (!daemon.start(argv[2])) return 1;
+        int signal;
+        sigwait(&signals, &signal);
+        daemon.stop();
+        return 0;
+    }
     testChuLiuEdmonds();
+    testChromeTrace();
+    testCountingMemoryResource();
+    testArenaSolve();
+    testWorkspaceSolve();
+    testCAbi();
+    testGraphFile();
+    testNodeIdMap();
+    testEdgeListParser();
+    testCompressedGraph();
+    testSemiExternal();
+    testTarjanSolve();
+    testBatchPipeline();
+    testResultFile();
+    testSolverDaemon();
+    testResultCache();
+    testAsyncSolve();
+    testDynamicArborescence();
+    testWarmStart();
+    testEdgeConstraints();
+    testKBestArborescences();
+    testSingleRootChild();
+    testBestRoot();
+    testMinimumBranching();
+    testReachableArborescence();
     runChuLiuEdmondsSample();
     return 0;
 }
+
+#endif // EDMONDS_NO_MAIN
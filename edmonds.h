@@ -0,0 +1,69 @@
+/*
+ * Stable C ABI for the Chu-Liu/Edmonds minimum spanning arborescence solver in edmonds.cc.
+ *
+ * Build as a shared library with
+ *     g++ -std=c++20 -O2 -pthread -shared -fPIC -fvisibility=hidden -DEDMONDS_NO_MAIN edmonds.cc -o libedmonds.so
+ * Only the functions declared here are exported. Edges are read in place, either as a packed
+ * edmonds_edge array or as three parallel int32 arrays, and all scratch memory can be supplied by
+ * the caller, so foreign runtimes can pass the buffers they already hold.
+ */
+#ifndef EDMONDS_H
+#define EDMONDS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define EDMONDS_API __declspec(dllexport)
+#else
+#define EDMONDS_API __attribute__((visibility("default")))
+#endif
+
+/* Bumped whenever a declaration in this header changes incompatibly. */
+#define EDMONDS_ABI_VERSION 2
+
+/* Status codes returned by the solve functions. */
+#define EDMONDS_OK 0
+#define EDMONDS_NO_ARBORESCENCE 1
+#define EDMONDS_WORKSPACE_TOO_SMALL 2
+#define EDMONDS_INVALID_ARGUMENT 3
+#define EDMONDS_OUT_OF_MEMORY 4
+
+/* A directed edge; 12 bytes, 4-byte aligned, no padding. */
+typedef struct edmonds_edge {
+    int32_t from;
+    int32_t to;
+    int32_t weight;
+} edmonds_edge;
+
+/* Returns EDMONDS_ABI_VERSION of the loaded library. */
+EDMONDS_API uint32_t edmonds_abi_version(void);
+
+/* Bytes of scratch memory a solve of n nodes and num_edges edges needs; the block must be 4-byte aligned. */
+EDMONDS_API size_t edmonds_workspace_bytes(int32_t n, size_t num_edges);
+
+/*
+ * Solves for the minimum spanning arborescence rooted at root over a packed edge array.
+ * workspace may be NULL, in which case the library allocates it; otherwise it must hold at least
+ * edmonds_workspace_bytes(n, num_edges) bytes. On EDMONDS_OK, *total receives the arborescence weight.
+ * parent may be NULL; otherwise it must hold n elements and on EDMONDS_OK receives each node's
+ * parent in the arborescence, -1 for the root. Such a solve uses the library's O(E log V) engine,
+ * which allocates its own memory and ignores workspace.
+ */
+EDMONDS_API int edmonds_solve_edges(int32_t n, int32_t root, const edmonds_edge* edges, size_t num_edges,
+                                    void* workspace, size_t workspace_bytes, int32_t* total, int32_t* parent);
+
+/* As edmonds_solve_edges, with the edges given as three parallel arrays of num_edges elements. */
+EDMONDS_API int edmonds_solve_arrays(int32_t n, int32_t root, const int32_t* from, const int32_t* to,
+                                     const int32_t* weight, size_t num_edges,
+                                     void* workspace, size_t workspace_bytes, int32_t* total, int32_t* parent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDMONDS_H */